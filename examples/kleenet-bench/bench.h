@@ -0,0 +1,194 @@
+/*
+ * Common scaffolding of the KleeNet benchmark programs.
+ *
+ * Every program is compiled once per configuration:
+ *   -DBENCH_NODES=n       number of nodes (ids 1..n)
+ *   -DBENCH_TOPOLOGY=t    BENCH_RING, BENCH_STAR or BENCH_MESH
+ *   -DBENCH_SYMBOLIC=k    number of symbolic payload fields per packet
+ *   -DBENCH_ROUNDS=r      number of protocol rounds
+ *
+ * Time is virtual: under the cooja searchers a tick is a scheduler tick,
+ * under the lock-step searchers (which ignore scheduling requests) it is one
+ * lock-step round. Every program checks that the packets it waits for were
+ * delivered and reports a bench.err error otherwise.
+ */
+
+#ifndef KLEENET_BENCH_H
+#define KLEENET_BENCH_H
+
+#include <klee/klee.h>
+#include <kleenet/interface/kleenet.h>
+
+#define BENCH_RING 0
+#define BENCH_STAR 1
+#define BENCH_MESH 2
+
+#ifndef BENCH_NODES
+#define BENCH_NODES 3
+#endif
+#ifndef BENCH_TOPOLOGY
+#define BENCH_TOPOLOGY BENCH_RING
+#endif
+#ifndef BENCH_SYMBOLIC
+#define BENCH_SYMBOLIC 1
+#endif
+#ifndef BENCH_ROUNDS
+#define BENCH_ROUNDS 1
+#endif
+/* Ticks every node waits after booting, so that all of them have their node
+ * id before the first packet is sent. */
+#ifndef BENCH_BOOT
+#define BENCH_BOOT (32 * BENCH_NODES)
+#endif
+/* Ticks a receiver sleeps between two looks into its inbox. Senders wake
+ * their receivers up, so this only bounds the latency of missed wake-ups. */
+#ifndef BENCH_POLL
+#define BENCH_POLL 8
+#endif
+/* Ticks without any packet after which a receiver gives up. */
+#ifndef BENCH_TIMEOUT
+#define BENCH_TIMEOUT (512 * BENCH_NODES)
+#endif
+
+#define BENCH_FIELDS 4
+/* Inbox slots per sender; no sender ever sends more packets to one
+ * neighbour than this. */
+#define BENCH_QUEUE (2 * BENCH_NODES * BENCH_ROUNDS)
+
+#if BENCH_NODES < 2
+#error "a network needs at least two nodes"
+#endif
+#if BENCH_SYMBOLIC > BENCH_FIELDS
+#error "BENCH_SYMBOLIC exceeds BENCH_FIELDS"
+#endif
+
+struct bench_packet {
+  int src;
+  int dst; /* 0 for broadcasts */
+  int seq;
+  int ttl;
+  int fields[BENCH_FIELDS];
+};
+
+/* Node 1 is the hub of the star. */
+static int bench_is_neighbour(int a, int b) {
+  if (a == b)
+    return 0;
+  switch (BENCH_TOPOLOGY) {
+    case BENCH_RING:
+      return b == a % BENCH_NODES + 1 || a == b % BENCH_NODES + 1;
+    case BENCH_STAR:
+      return a == 1 || b == 1;
+    default:
+      return 1;
+  }
+}
+
+/* The neighbour to send a packet for dest to. */
+static int bench_next_hop(int self, int dest) {
+  if (bench_is_neighbour(self, dest))
+    return dest;
+  switch (BENCH_TOPOLOGY) {
+    case BENCH_RING:
+      /* go the shorter way round */
+      if ((dest - self + BENCH_NODES) % BENCH_NODES <= BENCH_NODES / 2)
+        return self % BENCH_NODES + 1;
+      return (self + BENCH_NODES - 2) % BENCH_NODES + 1;
+    default:
+      return 1;
+  }
+}
+
+/* Reports a bench.err error unless got equals want. */
+#define bench_expect(got, want, what)                                       \
+  do {                                                                      \
+    if ((got) != (want))                                                    \
+      klee_report_error(__FILE__, __LINE__, what, "bench.err");             \
+  } while (0)
+
+/* Sleeps for the given number of ticks. */
+static void bench_sleep(unsigned long ticks) {
+  kleenet_schedule_state(ticks);
+  kleenet_yield_state();
+}
+
+/* Splits the initial state into one state per node and returns the id of
+ * the node the calling state now belongs to. Returns once every node is
+ * up, at the same virtual time on all of them. */
+static int bench_boot(void) {
+  int selector, id;
+  klee_make_symbolic(&selector, sizeof(selector), "bench_node");
+  for (id = 1; id < BENCH_NODES; ++id)
+    if (selector == id)
+      break;
+  kleenet_set_node_id(id);
+  while (kleenet_get_virtual_time() < BENCH_BOOT)
+    bench_sleep(1);
+  return id;
+}
+
+/* Fills in a packet whose first BENCH_SYMBOLIC payload fields are symbolic. */
+static void bench_make_packet(struct bench_packet *p, int src, int dst,
+                              int seq) {
+  int i;
+  p->src = src;
+  p->dst = dst;
+  p->seq = seq;
+  p->ttl = BENCH_NODES;
+  for (i = 0; i != BENCH_FIELDS; ++i)
+    p->fields[i] = i;
+  if (BENCH_SYMBOLIC)
+    klee_make_symbolic(p->fields, BENCH_SYMBOLIC * sizeof(p->fields[0]),
+                       "bench_fields");
+}
+
+/* Branches on every symbolic payload field, so that each packet doubles the
+ * number of paths of its receiver. */
+static int bench_inspect(struct bench_packet const *p) {
+  int i, score = 0;
+  for (i = 0; i != BENCH_SYMBOLIC; ++i)
+    if (p->fields[i] > i)
+      ++score;
+  return score;
+}
+
+/* Every node has a queue of inbox slots per sender; senders raise a slot's
+ * flag after the packet itself, receivers lower it once they took the
+ * packet. bench_sent lives on the sender, bench_taken on the receiver. */
+static struct bench_packet bench_inbox[BENCH_NODES + 1][BENCH_QUEUE];
+static int bench_full[BENCH_NODES + 1][BENCH_QUEUE];
+static int bench_sent[BENCH_NODES + 1];
+static int bench_taken[BENCH_NODES + 1];
+
+static void bench_send(int self, int dest, struct bench_packet const *p) {
+  int const slot = bench_sent[dest]++;
+  if (slot == BENCH_QUEUE)
+    klee_report_error(__FILE__, __LINE__, "inbox overflow", "bench.err");
+  kleenet_memcpy(&bench_inbox[self][slot], p, sizeof(*p), dest);
+  kleenet_memset(&bench_full[self][slot], 1, sizeof(bench_full[self][slot]),
+                 dest);
+  kleenet_wakeup_dest_states(dest);
+}
+
+/* Takes the next pending packet out of the inbox, sleeping until one
+ * arrives. Gives up after BENCH_TIMEOUT ticks and returns 0 then. */
+static int bench_receive(struct bench_packet *p) {
+  unsigned long const deadline = kleenet_get_virtual_time() + BENCH_TIMEOUT;
+  int n;
+  for (;;) {
+    for (n = 1; n <= BENCH_NODES; ++n) {
+      int const slot = bench_taken[n];
+      if (slot != BENCH_QUEUE && bench_full[n][slot]) {
+        bench_full[n][slot] = 0;
+        ++bench_taken[n];
+        *p = bench_inbox[n][slot];
+        return 1;
+      }
+    }
+    if (kleenet_get_virtual_time() >= deadline)
+      return 0;
+    bench_sleep(BENCH_POLL);
+  }
+}
+
+#endif
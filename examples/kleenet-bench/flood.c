@@ -0,0 +1,46 @@
+/*
+ * Flooding: every round, node 1 broadcasts a packet with symbolic payload.
+ * Each node inspects the first copy of a round's packet it receives and
+ * forwards it to all of its neighbours but the one it came from. Every node
+ * has to see every round.
+ */
+
+#include "bench.h"
+
+static void flood(int self, struct bench_packet const *p, int except) {
+  int n;
+  for (n = 1; n <= BENCH_NODES; ++n)
+    if (n != except && bench_is_neighbour(self, n))
+      bench_send(self, n, p);
+}
+
+int main() {
+  int const self = bench_boot();
+  struct bench_packet p;
+  int seen[BENCH_ROUNDS + 1] = { 0 };
+  int delivered = 0, score = 0;
+  int round;
+
+  if (self == 1) {
+    for (round = 1; round <= BENCH_ROUNDS; ++round) {
+      bench_make_packet(&p, self, 0, round);
+      flood(self, &p, 0);
+    }
+    return 0;
+  }
+
+  /* rounds may overtake each other on different routes */
+  while (delivered < BENCH_ROUNDS && bench_receive(&p)) {
+    int const from = p.src;
+    if (p.seq < 1 || p.seq > BENCH_ROUNDS || seen[p.seq] || p.ttl <= 0)
+      continue; /* duplicate */
+    seen[p.seq] = 1;
+    ++delivered;
+    score += bench_inspect(&p);
+    p.src = self;
+    --p.ttl;
+    flood(self, &p, from);
+  }
+  bench_expect(delivered, BENCH_ROUNDS, "flood: rounds lost");
+  return score;
+}
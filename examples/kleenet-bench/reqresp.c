@@ -0,0 +1,59 @@
+/*
+ * Request/response: every round, each node but node 1 sends a request with
+ * symbolic payload to node 1, which answers with a verdict on the payload.
+ * Nodes that are not adjacent to the server route through their neighbours
+ * (see bench_next_hop), so every node keeps relaying until the network has
+ * been quiet for BENCH_TIMEOUT ticks.
+ */
+
+#include "bench.h"
+
+#define SERVER 1
+
+static int self, round, pending, accepted, served;
+
+static void route(struct bench_packet *p) {
+  --p->ttl;
+  bench_send(self, bench_next_hop(self, p->dst), p);
+}
+
+static void handle(struct bench_packet *p) {
+  if (p->ttl <= 0)
+    return;
+  if (p->dst != self) {
+    route(p);
+  } else if (self == SERVER) {
+    ++served;
+    p->fields[0] = bench_inspect(p);
+    p->dst = p->src;
+    p->src = self;
+    p->ttl = BENCH_NODES;
+    route(p);
+  } else if (pending && p->seq == round) {
+    pending = 0;
+    if (p->fields[0] > BENCH_SYMBOLIC / 2)
+      ++accepted;
+  }
+}
+
+int main() {
+  struct bench_packet p;
+
+  self = bench_boot();
+  if (self != SERVER) {
+    for (round = 1; round <= BENCH_ROUNDS; ++round) {
+      bench_make_packet(&p, self, SERVER, round);
+      route(&p);
+      pending = 1;
+      while (pending && bench_receive(&p))
+        handle(&p);
+      bench_expect(pending, 0, "reqresp: no response");
+    }
+  }
+  while (bench_receive(&p))
+    handle(&p);
+  if (self == SERVER)
+    bench_expect(served, (BENCH_NODES - 1) * BENCH_ROUNDS,
+                 "reqresp: requests lost");
+  return accepted;
+}
@@ -0,0 +1,187 @@
+#!/usr/bin/env python
+# -*- encoding: utf-8 -*-
+
+"""Run the KleeNet benchmark programs under every state mapper and net
+searcher and report their throughput.
+
+A run only counts as ok if kleenet exited cleanly, no test case reports an
+error (the programs report bench.err when packets were lost) and packets
+were actually transmitted."""
+
+from __future__ import division
+from __future__ import print_function
+
+import argparse
+import glob
+import itertools
+import os
+import re
+import subprocess
+import sys
+import time
+
+Here = os.path.dirname(os.path.abspath(__file__))
+
+Programs = ['flood', 'reqresp']
+Topologies = {'ring': 'BENCH_RING', 'star': 'BENCH_STAR', 'mesh': 'BENCH_MESH'}
+Mappers = ['cob', 'cow', 'cow2', 'sds', 'sds-bfc', 'sds-sc']
+Searchers = {
+    'lockstep': '--sde-use-lockstep-search',
+    'cooja': '--sde-use-cooja-search',
+    'lockstep-cluster': '--sde-use-lockstep-cluster-search',
+    'cooja-cluster': '--sde-use-cooja-cluster-search',
+}
+# sds does not maintain clusters, so the cluster searchers cannot work on it
+Unsupported = set([('sds', 'lockstep-cluster'), ('sds', 'cooja-cluster')])
+
+Columns = ['program', 'topology', 'nodes', 'mapper', 'searcher', 'status',
+           'time(s)', 'paths/s', 'dscenarios/s', 'tx', 'maxRSS(MB)',
+           'solver(s)']
+
+
+def compileProgram(args, program, topology, nodes, bitcode):
+    cmd = [args.clang, '-emit-llvm', '-c', '-g', '-O0',
+           '-I', args.include,
+           '-DBENCH_NODES={0}'.format(nodes),
+           '-DBENCH_TOPOLOGY={0}'.format(Topologies[topology]),
+           '-DBENCH_SYMBOLIC={0}'.format(args.symbolic),
+           '-DBENCH_ROUNDS={0}'.format(args.rounds),
+           os.path.join(Here, program + '.c'), '-o', bitcode]
+    subprocess.check_call(cmd)
+
+
+def runKleeNet(args, bitcode, mapper, searcher, outDir):
+    """Returns exit status, wall time and peak RSS (in MB) of the run."""
+    cmd = [args.kleenet, '--output-dir=' + outDir,
+           '--max-time={0}'.format(args.max_time),
+           '--sde-state-mapping=' + mapper, Searchers[searcher],
+           bitcode]
+    with open(os.devnull, 'w') as devnull:
+        start = time.time()
+        proc = subprocess.Popen(cmd, stdout=devnull, stderr=devnull)
+        _, status, usage = os.wait4(proc.pid, 0)
+        wall = time.time() - start
+    return status, wall, usage.ru_maxrss / 1024
+
+
+def readInfo(outDir):
+    values = {}
+    try:
+        for line in open(os.path.join(outDir, 'info')):
+            m = re.match(r'KleeNet: done: ([a-z ]+) = (\d+)', line)
+            if m:
+                values[m.group(1)] = int(m.group(2))
+    except IOError:
+        pass
+    return values
+
+
+def readStats(outDir):
+    """Returns the last record of run.stats as a dictionary."""
+    try:
+        lines = open(os.path.join(outDir, 'run.stats')).read().splitlines()
+    except IOError:
+        return {}
+    if len(lines) < 2:
+        return {}
+    return dict(zip(eval(lines[0]), eval(lines[-1])))
+
+
+def runStatus(exitStatus, outDir, stats):
+    if exitStatus != 0:
+        return 'failed'
+    if glob.glob(os.path.join(outDir, '*.err')):
+        return 'errors'
+    if not stats.get('Transmissions'):
+        return 'no-tx'
+    return 'ok'
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('--kleenet', default='kleenet',
+                        help='kleenet binary (default: kleenet)')
+    parser.add_argument('--clang', default='clang',
+                        help='clang used to build the bitcode (default: clang)')
+    parser.add_argument('--include',
+                        default=os.path.join(Here, '..', '..', 'include'),
+                        help='include directory with klee/klee.h and '
+                        'kleenet/interface/kleenet.h')
+    parser.add_argument('--programs', default=','.join(Programs))
+    parser.add_argument('--topologies', default='ring,star,mesh')
+    parser.add_argument('--nodes', default='3,5',
+                        help='comma separated node counts (default: 3,5)')
+    parser.add_argument('--mappers', default=','.join(Mappers))
+    parser.add_argument('--searchers',
+                        default='lockstep,cooja,lockstep-cluster,cooja-cluster')
+    parser.add_argument('--symbolic', type=int, default=1,
+                        help='symbolic payload fields per packet (default: 1)')
+    parser.add_argument('--rounds', type=int, default=1,
+                        help='protocol rounds (default: 1)')
+    parser.add_argument('--max-time', type=int, default=60,
+                        help='time limit per run in seconds (default: 60)')
+    parser.add_argument('--work-dir', default='kleenet-bench-out',
+                        help='directory for bitcode and klee output')
+    parser.add_argument('--csv', help='also write the results to this file')
+    parser.add_argument('--report',
+                        help='also write the result table to this file')
+    args = parser.parse_args()
+
+    if os.path.exists(args.work_dir):
+        print('error: {0} already exists'.format(args.work_dir),
+              file=sys.stderr)
+        return 1
+    os.makedirs(args.work_dir)
+
+    rows = []
+    configs = itertools.product(args.programs.split(','),
+                                args.topologies.split(','),
+                                [int(n) for n in args.nodes.split(',')])
+    for program, topology, nodes in configs:
+        name = '{0}-{1}-{2}'.format(program, topology, nodes)
+        bitcode = os.path.join(args.work_dir, name + '.bc')
+        compileProgram(args, program, topology, nodes, bitcode)
+        for mapper, searcher in itertools.product(args.mappers.split(','),
+                                                  args.searchers.split(',')):
+            row = [program, topology, nodes, mapper, searcher]
+            if (mapper, searcher) in Unsupported:
+                rows.append(row + ['n/a'] + [''] * 6)
+                continue
+            outDir = os.path.join(args.work_dir,
+                                  '{0}-{1}-{2}'.format(name, mapper, searcher))
+            status, wall, rss = runKleeNet(args, bitcode, mapper, searcher,
+                                           outDir)
+            info = readInfo(outDir)
+            stats = readStats(outDir)
+            row += [runStatus(status, outDir, stats),
+                    '{0:.2f}'.format(wall),
+                    '{0:.2f}'.format(info.get('completed paths', 0) / wall),
+                    '{0:.2f}'.format(info.get('explored dscenarios', 0) / wall),
+                    stats.get('Transmissions', 0),
+                    '{0:.1f}'.format(rss),
+                    '{0:.2f}'.format(stats.get('SolverTime', 0))]
+            rows.append(row)
+            print(' '.join(str(c) for c in row))
+            sys.stdout.flush()
+
+    widths = [max(len(str(r[i])) for r in [Columns] + rows)
+              for i in range(len(Columns))]
+    table = ['  '.join(str(c).rjust(w) for c, w in zip(r, widths))
+             for r in [Columns] + rows]
+    print()
+    print('\n'.join(table))
+
+    if args.report:
+        with open(args.report, 'w') as f:
+            f.write(' '.join(sys.argv) + '\n\n')
+            f.write('\n'.join(table) + '\n')
+
+    if args.csv:
+        with open(args.csv, 'w') as f:
+            for r in [Columns] + rows:
+                f.write(','.join(str(c) for c in r) + '\n')
+    return 0 if all(r[5] in ('ok', 'n/a') for r in rows) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
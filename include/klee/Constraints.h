@@ -11,6 +11,7 @@
 #define KLEE_CONSTRAINTS_H
 
 #include "klee/Expr.h"
+#include "klee/util/ConstraintIndex.h"
 
 // FIXME: Currently we use ConstraintManager for two things: to pass
 // sets of constraints around, and to optimize constraints. We should
@@ -33,7 +34,8 @@ public:
   ConstraintManager(const std::vector< ref<Expr> > &_constraints) :
     constraints(_constraints) {}
 
-  ConstraintManager(const ConstraintManager &cs) : constraints(cs.constraints) {}
+  ConstraintManager(const ConstraintManager &cs)
+    : constraints(cs.constraints), index(cs.index) {}
 
   typedef std::vector< ref<Expr> >::const_iterator constraint_iterator;
 
@@ -61,12 +63,21 @@ public:
     return constraints.size();
   }
 
+  /// Appends all constraints which are transitively connected to any of the
+  /// given arrays through shared reads to \a result, in the order in which
+  /// they appear in this set. Maintained incrementally, so the cost depends
+  /// on the size of the result rather than on the size of the set.
+  void getDependentConstraints(const std::vector<const Array*> &arrays,
+                               std::vector< ref<Expr> > &result) const;
+
   bool operator==(const ConstraintManager &other) const {
     return constraints == other.constraints;
   }
   
 private:
   std::vector< ref<Expr> > constraints;
+  // lazily caught up with 'constraints'; cleared when they are rewritten
+  mutable ConstraintIndex index;
 
   // returns true iff the constraints were modified
   bool rewriteConstraints(ExprVisitor &visitor);
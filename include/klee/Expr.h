@@ -92,6 +92,8 @@ Todo: Shouldn't bool \c Xor just be written as not equal?
 class Expr {
 public:
   static unsigned count;
+  /// Set by -hash-cons-exprs, see hashCons().
+  static bool hashConsing;
   static const unsigned MAGIC_HASH_CONSTANT = 39;
 
   /// The type of an expression is simply its width, in bits. 
@@ -204,8 +206,12 @@ protected:
   virtual int compareContents(const Expr &b) const = 0;
 
 public:
-  Expr() : refCount(0) { Expr::count++; }
-  virtual ~Expr() { Expr::count--; } 
+  Expr() : refCount(0), consed(false) { incRefCount(Expr::count); }
+  virtual ~Expr() {
+    if (consed)
+      forgetUnique(this);
+    decRefCount(Expr::count);
+  }
 
   virtual Kind getKind() const = 0;
   virtual Width getWidth() const = 0;
@@ -285,9 +291,28 @@ public:
 
   static bool classof(const Expr *) { return true; }
 
+  /// With hash-consing enabled, returns the node that already exists for an
+  /// expression structurally equal to `e`. If there is none, `e` becomes that
+  /// node. The unique table does not keep its nodes alive. Every alloc() goes
+  /// through here, so equal expressions share one node and compare equal on
+  /// pointer identity.
+  template<class T>
+  static ref<T> hashCons(const ref<T> &e) {
+    if (!hashConsing)
+      return e;
+    return ref<T>(static_cast<T *>(unique(e.get()).get()));
+  }
+
 private:
   typedef llvm::DenseSet<std::pair<const Expr *, const Expr *> > ExprEquivSet;
   int compare(const Expr &b, ExprEquivSet &equivs) const;
+
+  /// Whether this node is in the unique table. Nodes leave the table when
+  /// they die, even if hash-consing has been switched off since.
+  bool consed;
+
+  static ref<Expr> unique(Expr *e);
+  static void forgetUnique(Expr *e);
 };
 
 struct Expr::CreateArg {
@@ -420,7 +445,7 @@ public:
   static ref<Expr> alloc(const ref<Expr> &src) {
     ref<Expr> r(new NotOptimizedExpr(src));
     r->computeHash();
-    return r;
+    return hashCons(r);
   }
   
   static ref<Expr> create(ref<Expr> src);
@@ -579,7 +604,7 @@ public:
   static ref<Expr> alloc(const UpdateList &updates, const ref<Expr> &index) {
     ref<Expr> r(new ReadExpr(updates, index));
     r->computeHash();
-    return r;
+    return hashCons(r);
   }
   
   static ref<Expr> create(const UpdateList &updates, ref<Expr> i);
@@ -624,7 +649,7 @@ public:
                          const ref<Expr> &f) {
     ref<Expr> r(new SelectExpr(c, t, f));
     r->computeHash();
-    return r;
+    return hashCons(r);
   }
   
   static ref<Expr> create(ref<Expr> c, ref<Expr> t, ref<Expr> f);
@@ -687,7 +712,7 @@ public:
   static ref<Expr> alloc(const ref<Expr> &l, const ref<Expr> &r) {
     ref<Expr> c(new ConcatExpr(l, r));
     c->computeHash();
-    return c;
+    return hashCons(c);
   }
   
   static ref<Expr> create(const ref<Expr> &l, const ref<Expr> &r);
@@ -754,7 +779,7 @@ public:
   static ref<Expr> alloc(const ref<Expr> &e, unsigned o, Width w) {
     ref<Expr> r(new ExtractExpr(e, o, w));
     r->computeHash();
-    return r;
+    return hashCons(r);
   }
   
   /// Creates an ExtractExpr with the given bit offset and width
@@ -805,7 +830,7 @@ public:
   static ref<Expr> alloc(const ref<Expr> &e) {
     ref<Expr> r(new NotExpr(e));
     r->computeHash();
-    return r;
+    return hashCons(r);
   }
   
   static ref<Expr> create(const ref<Expr> &e);
@@ -882,7 +907,7 @@ public:                                                          \
     static ref<Expr> alloc(const ref<Expr> &e, Width w) {        \
       ref<Expr> r(new _class_kind ## Expr(e, w));                \
       r->computeHash();                                          \
-      return r;                                                  \
+      return hashCons(r);                                        \
     }                                                            \
     static ref<Expr> create(const ref<Expr> &e, Width w);        \
     Kind getKind() const { return _class_kind; }                 \
@@ -915,7 +940,7 @@ CAST_EXPR_CLASS(ZExt)
     static ref<Expr> alloc(const ref<Expr> &l, const ref<Expr> &r) {           \
       ref<Expr> res(new _class_kind##Expr(l, r));                              \
       res->computeHash();                                                      \
-      return res;                                                              \
+      return hashCons(res);                                                    \
     }                                                                          \
     static ref<Expr> create(const ref<Expr> &l, const ref<Expr> &r);           \
     Width getWidth() const { return left->getWidth(); }                        \
@@ -964,7 +989,7 @@ ARITHMETIC_EXPR_CLASS(AShr)
     static ref<Expr> alloc(const ref<Expr> &l, const ref<Expr> &r) {           \
       ref<Expr> res(new _class_kind##Expr(l, r));                              \
       res->computeHash();                                                      \
-      return res;                                                              \
+      return hashCons(res);                                                    \
     }                                                                          \
     static ref<Expr> create(const ref<Expr> &l, const ref<Expr> &r);           \
     Kind getKind() const { return _class_kind; }                               \
@@ -1069,7 +1094,7 @@ public:
   static ref<ConstantExpr> alloc(const llvm::APInt &v) {
     ref<ConstantExpr> r(new ConstantExpr(v));
     r->computeHash();
-    return r;
+    return hashCons(r);
   }
 
   static ref<ConstantExpr> alloc(const llvm::APFloat &f) {
@@ -11,12 +11,76 @@
 #define KLEE_CELL_H
 
 #include <klee/Expr.h>
+#include <klee/util/Bits.h>
 
 namespace klee {
   class MemoryObject;
 
+  /// A register of the interpreter.
+  ///
+  /// Constants of up to 64 bits are kept as plain machine words, so that the
+  /// interpreter can compute concrete results without allocating expressions.
+  /// The ConstantExpr of such a cell is only built when somebody asks for the
+  /// value() and it is then kept until the cell is bound again. A cell that
+  /// was never bound isNull().
   struct Cell {
-    ref<Expr> value;
+  private:
+    mutable ref<Expr> expr;
+    uint64_t bits;
+    /// The width of the small constant in bits, 0 if there is none.
+    Expr::Width width;
+
+  public:
+    Cell() : expr(), bits(0), width(0) {}
+
+    bool isNull() const {
+      return !width && expr.isNull();
+    }
+
+    bool isSmallConstant() const {
+      return width != 0;
+    }
+
+    /// The width of the small constant.
+    Expr::Width getWidth() const {
+      assert(isSmallConstant());
+      return width;
+    }
+
+    uint64_t getZExtValue() const {
+      assert(isSmallConstant());
+      return bits;
+    }
+
+    int64_t getSExtValue() const {
+      assert(isSmallConstant());
+      return int64_t(bits << (64 - width)) >> (64 - width);
+    }
+
+    ref<Expr> value() const {
+      if (width && expr.isNull())
+        expr = ConstantExpr::create(bits, width);
+      return expr;
+    }
+
+    void bind(const ref<Expr> &e) {
+      expr = e;
+      width = 0;
+      if (ConstantExpr *ce = dyn_cast_or_null<ConstantExpr>(e.get())) {
+        if (ce->getWidth() <= Expr::Int64) {
+          bits = ce->getZExtValue();
+          width = ce->getWidth();
+        }
+      }
+    }
+
+    /// Binds the constant value, truncated to w bits.
+    void bindConstant(uint64_t value, Expr::Width w) {
+      assert(w > 0 && w <= Expr::Int64 && "not a small constant");
+      expr = ref<Expr>();
+      bits = bits64::truncateToNBits(value, w);
+      width = w;
+    }
   };
 }
 
@@ -41,6 +41,12 @@ namespace klee {
     int *operands;
     /// Destination register index.
     unsigned dest;
+    /// The opcode of inst, so that dispatching does not have to look into
+    /// the LLVM instruction.
+    unsigned opcode;
+    /// Width of the result in bits (as Executor::getWidthForLLVMType would
+    /// compute it), 0 if the result has no size.
+    unsigned width;
 
   public:
     virtual ~KInstruction();
@@ -123,6 +123,19 @@ public:
   // a user specified path. use null to reset.
   virtual void setReplayPath(const std::vector<bool> *path) = 0;
 
+  // restrict exploration to one of 'count' disjoint shards of the
+  // execution tree. cooperating processes started with the same input and
+  // options but different indices explore the whole tree between them, as
+  // long as their executions are deterministic up to where they split.
+  // every split is logged to shard-splits.txt in the output directory, so
+  // that the shards' logs can be compared to find out whether they were.
+  virtual void setShard(unsigned index, unsigned count) = 0;
+
+  // true while the part of the tree this process is in is also explored by
+  // a shard with a lower index, which is the one to report results for it.
+  // stays true if the execution ends before this shard is split off.
+  virtual bool isShardRedundant() const = 0;
+
   // supply a set of symbolic bindings that will be used as "seeds"
   // for the search. use null to reset.
   virtual void useSeeds(const std::vector<struct KTest *> *seeds) = 0;
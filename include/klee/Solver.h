@@ -274,6 +274,14 @@ namespace klee {
   /// \param s - The underlying solver to use.
   Solver *createCachingSolver(Solver *s);
 
+  /// createPersistentCachingSolver - Create a solver which records the results
+  /// of the queries it forwards in a file and answers repeated queries from
+  /// that file, also across separate runs.
+  ///
+  /// \param s - The underlying solver to use.
+  /// \param path - The cache file; it is created if it does not exist.
+  Solver *createPersistentCachingSolver(Solver *s, std::string path);
+
   /// createCexCachingSolver - Create a counterexample caching solver. This is a
   /// more sophisticated cache which records counterexamples for a constraint
   /// set and uses subset/superset relations among constraints to try and
@@ -35,6 +35,16 @@ public:
   void set(unsigned idx) { bits[idx/32] |= 1<<(idx&0x1F); }
   void unset(unsigned idx) { bits[idx/32] &= ~(1<<(idx&0x1F)); }
   void set(unsigned idx, bool value) { if (value) set(idx); else unset(idx); }
+
+  /// Set the bits in [begin, end), whole words at a time where possible.
+  void setRange(unsigned begin, unsigned end) {
+    for (; begin != end && (begin & 0x1F); ++begin)
+      set(begin);
+    for (; end - begin >= 32; begin += 32)
+      bits[begin/32] = 0xFFFFFFFF;
+    for (; begin != end; ++begin)
+      set(begin);
+  }
 };
 
 } // End klee namespace
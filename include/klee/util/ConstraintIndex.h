@@ -0,0 +1,60 @@
+//===-- ConstraintIndex.h ---------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_CONSTRAINTINDEX_H
+#define KLEE_CONSTRAINTINDEX_H
+
+#include "klee/Expr.h"
+
+#include <map>
+#include <vector>
+
+namespace klee {
+
+/// Union-find over the arrays read by a sequence of constraints. Two arrays
+/// end up in the same class iff some chain of constraints connects them, and
+/// every class remembers the positions of the constraints touching it.
+/// Reads of constant arrays without updates do not connect anything.
+///
+/// The index is grown by appending constraints; it has no notion of
+/// constraints being changed or removed, so it has to be cleared whenever
+/// that happens.
+class ConstraintIndex {
+private:
+  typedef std::map<const Array*, unsigned> ids_ty;
+
+  ids_ty ids;
+  std::vector<unsigned> parent;
+  std::vector<unsigned> rank;
+  /// Constraint positions (unordered), only valid at class representatives.
+  std::vector< std::vector<unsigned> > members;
+  /// Number of constraints seen so far.
+  unsigned indexed;
+
+  unsigned idOf(const Array *array);
+  unsigned find(unsigned id);
+  unsigned unite(unsigned a, unsigned b);
+
+public:
+  ConstraintIndex() : indexed(0) {}
+
+  void clear();
+
+  /// Index all constraints past the ones already seen.
+  void update(const std::vector< ref<Expr> > &constraints);
+
+  /// Appends the positions of all constraints which are connected to any of
+  /// the given arrays to \a result, in ascending order.
+  void getDependentPositions(const std::vector<const Array*> &arrays,
+                             std::vector<unsigned> &result);
+};
+
+}
+
+#endif /* KLEE_CONSTRAINTINDEX_H */
@@ -0,0 +1,187 @@
+//===-- PagedArray.h --------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef KLEE_UTIL_PAGEDARRAY_H
+#define KLEE_UTIL_PAGEDARRAY_H
+
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <vector>
+
+namespace klee {
+
+/// A fixed size array that is split into pages. Copies share their pages,
+/// a page is only duplicated once one of the copies writes to it. Writing a
+/// byte into a large object after a fork thus copies a page, not the object.
+/// The last page is only as long as it needs to be, so objects of at most one
+/// page cost about as much as a plain array.
+template<typename T>
+class PagedArray {
+public:
+  static const unsigned PageBits = 8;
+  static const unsigned PageSize = 1u << PageBits;
+
+private:
+  class Page {
+  private:
+    unsigned refCount;
+    unsigned length;
+
+    explicit Page(unsigned length) : refCount(1), length(length) {}
+    ~Page() {}
+
+  public:
+    T *data() { return reinterpret_cast<T*>(this + 1); }
+    const T *data() const { return reinterpret_cast<const T*>(this + 1); }
+    unsigned size() const { return length; }
+
+    static Page *create(unsigned length, const T *values = 0) {
+      Page *p = new (::operator new(sizeof(Page) + length * sizeof(T))) Page(length);
+      for (unsigned i = 0; i != length; ++i)
+        new (p->data() + i) T(values ? values[i] : T());
+      return p;
+    }
+
+    Page *retain() {
+      ++refCount;
+      return this;
+    }
+
+    void release() {
+      if (--refCount)
+        return;
+      for (unsigned i = 0; i != length; ++i)
+        data()[i].~T();
+      this->~Page();
+      ::operator delete(this);
+    }
+
+    bool isShared() const {
+      return refCount > 1;
+    }
+  };
+
+  std::vector<Page*> pages;
+  unsigned length;
+
+  // DO NOT IMPLEMENT
+  PagedArray &operator=(const PagedArray &);
+
+  /// The page at index, unshared from all copies.
+  Page *writeablePage(unsigned index) {
+    Page *&p = pages[index];
+    if (p->isShared()) {
+      Page *copy = Page::create(p->size(), p->data());
+      p->release();
+      p = copy;
+    }
+    return p;
+  }
+
+public:
+  /// Create an array of size value initialised elements.
+  explicit PagedArray(unsigned size) : pages(), length(size) {
+    pages.reserve((size + PageSize - 1) / PageSize);
+    for (unsigned base = 0; base < size; base += PageSize)
+      pages.push_back(Page::create(std::min(PageSize, size - base)));
+  }
+
+  PagedArray(const PagedArray &other) : pages(other.pages), length(other.length) {
+    for (unsigned i = 0; i != pages.size(); ++i)
+      pages[i]->retain();
+  }
+
+  ~PagedArray() {
+    for (unsigned i = 0; i != pages.size(); ++i)
+      pages[i]->release();
+  }
+
+  unsigned size() const { return length; }
+
+  const T &operator[](unsigned idx) const {
+    return pages[idx >> PageBits]->data()[idx & (PageSize - 1)];
+  }
+
+  /// Access an element for writing, which unshares its page.
+  T &getWriteable(unsigned idx) {
+    return writeablePage(idx >> PageBits)->data()[idx & (PageSize - 1)];
+  }
+
+  /// Set the elements in [begin, end) to value.
+  void fill(unsigned begin, unsigned end, const T &value) {
+    assert(begin <= end && end <= length && "Invalid fill range!");
+    while (begin != end) {
+      unsigned const offset = begin & (PageSize - 1);
+      unsigned const count = std::min(PageSize - offset, end - begin);
+      T *data = writeablePage(begin >> PageBits)->data() + offset;
+      std::fill(data, data + count, value);
+      begin += count;
+    }
+  }
+
+  /// Set the elements in [begin, end) to value, but only on the pages where
+  /// some element of the range satisfies pred. The other pages stay shared.
+  template<typename Pred>
+  void fill(unsigned begin, unsigned end, const T &value, Pred pred) {
+    assert(begin <= end && end <= length && "Invalid fill range!");
+    while (begin != end) {
+      unsigned const offset = begin & (PageSize - 1);
+      unsigned const count = std::min(PageSize - offset, end - begin);
+      const T *old = pages[begin >> PageBits]->data() + offset;
+      if (std::find_if(old, old + count, pred) != old + count) {
+        T *data = writeablePage(begin >> PageBits)->data() + offset;
+        std::fill(data, data + count, value);
+      }
+      begin += count;
+    }
+  }
+
+  /// Copy count values into the array, starting at offset.
+  void write(unsigned offset, const T *values, unsigned count) {
+    assert(offset + count <= length && "Invalid write range!");
+    while (count) {
+      unsigned const inPage = offset & (PageSize - 1);
+      unsigned const n = std::min(PageSize - inPage, count);
+      std::copy(values, values + n, writeablePage(offset >> PageBits)->data() + inPage);
+      offset += n;
+      values += n;
+      count -= n;
+    }
+  }
+
+  /// Copy all elements out to dest.
+  void read(T *dest) const {
+    for (unsigned i = 0; i != pages.size(); ++i)
+      dest = std::copy(pages[i]->data(), pages[i]->data() + pages[i]->size(), dest);
+  }
+
+  /// \returns true if the array holds the same elements as values.
+  bool equals(const T *values) const {
+    for (unsigned i = 0; i != pages.size(); values += pages[i]->size(), ++i)
+      if (!std::equal(pages[i]->data(), pages[i]->data() + pages[i]->size(), values))
+        return false;
+    return true;
+  }
+
+  /// Replace all elements by values. Pages that already hold the same
+  /// elements stay shared.
+  void assign(const T *values) {
+    for (unsigned i = 0; i != pages.size(); values += pages[i]->size(), ++i)
+      if (!std::equal(pages[i]->data(), pages[i]->data() + pages[i]->size(), values))
+        std::copy(values, values + pages[i]->size(), writeablePage(i)->data());
+  }
+};
+
+template<typename T> const unsigned PagedArray<T>::PageBits;
+template<typename T> const unsigned PagedArray<T>::PageSize;
+
+} // End klee namespace
+
+#endif
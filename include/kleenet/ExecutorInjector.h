@@ -52,6 +52,8 @@ namespace kleenet {
       virtual void terminateStateOnExit(klee::ExecutionState&) = 0;
       // call exit handler and terminate state
       virtual void terminateStateOnError(klee::ExecutionState&, llvm::Twine const&, TerminateReason, char const*, llvm::Twine const&) = 0;
+      // KleeNet: over the memory cap, we have to pick whole clusters as victims
+      virtual void killStatesOverMemoryCap(unsigned toKill) = 0;
       // KleeNet extension: we inject our own special-function-handlers by overriding this.
       virtual klee::SpecialFunctionHandler* newSpecialFunctionHandler() = 0;
       // KleeNet extension: we inject our own searchers by overriding this.
@@ -0,0 +1,51 @@
+#pragma once
+
+/* A KnTest archive keeps many test cases in a single, append-only file.
+ * Test cases are written in chunks; every chunk starts with an index of the
+ * test id, node id, dscenario id and size of each of its test cases, so a
+ * reader can stream through an archive and skip the test cases it is not
+ * interested in without decoding them. Each test case is stored exactly as
+ * it would be in its own .ktest file.
+ * A chunk cut short (e.g. by a crash while writing it) ends the archive.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  typedef struct KnTestArchive KnTestArchive;
+
+  /* return true iff file at path matches the archive header */
+  int knTestArchive_isArchive(const char *path);
+
+  /* creates (or truncates) an archive for writing. Test cases are
+   * buffered in memory and appended in chunks of chunkSize.
+   * returns NULL on (unspecified) error */
+  KnTestArchive* knTestArchive_create(const char *path, unsigned chunkSize);
+
+  /* returns 1 on success, 0 on (unspecified) error */
+  int knTestArchive_append(KnTestArchive*, KTest*, unsigned id);
+
+  /* opens an archive for reading; returns NULL on (unspecified) error */
+  KnTestArchive* knTestArchive_open(const char *path);
+
+  /* from now on, only hand out test cases of the given node and dscenario;
+   * -1 matches any */
+  void knTestArchive_select(KnTestArchive*, int nodeId, int dscenarioId);
+
+  /* returns the next selected test case (to be released with kTest_free)
+   * and stores its id, or NULL at the end of the archive */
+  KTest* knTestArchive_next(KnTestArchive*, unsigned *id);
+
+  /* writes out the pending test cases now, as a chunk of their own; does
+   * nothing for archives opened for reading.
+   * returns 1 on success, 0 on (unspecified) error */
+  int knTestArchive_flush(KnTestArchive*);
+
+  /* writes out the pending chunk, if any.
+   * returns 1 on success, 0 on (unspecified) error */
+  int knTestArchive_close(KnTestArchive*);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "net/Node.h"
+#include "net/Time.h"
+
+#include <vector>
+#include <cstddef>
+
+namespace net {
+  class BasicState;
+
+  /* Calendar queue (R. Brown, 1988) of state wakeup events.
+   * Events are ordered by time, then by node, then by insertion (FIFO).
+   * Each bucket covers one 'width' wide slice of time per 'year' and keeps its
+   * events in an intrusive sorted list, so insertion, removal and finding the
+   * earliest event are O(1) amortised as long as the bucket width matches the
+   * event density; the queue re-sizes itself whenever the number of events
+   * leaves [buckets/2, 2*buckets].
+   * Event records are pooled and never returned to the heap before the queue
+   * itself dies.
+   */
+  class CalendarQueue {
+    public:
+      struct Event {
+        friend class CalendarQueue;
+        private:
+          unsigned long long seq;
+          Event* prev;
+          Event* next;
+        public:
+          Time time;
+          Node node;
+          BasicState* state;
+          // free for use by the owner of the queue (e.g. to chain all events of one state)
+          Event* nextOfState;
+      };
+
+    private:
+      struct Bucket {
+        Event* head;
+        Event* tail;
+        Bucket() : head(NULL), tail(NULL) {}
+      };
+      typedef std::vector<Bucket> Buckets;
+      Buckets buckets;
+      Time width;
+      size_t events;
+      unsigned long long nextSeq;
+      // search position: the year of bucket 'lastBucket' ends before 'bucketTop'
+      size_t lastBucket;
+      Time bucketTop;
+      Event* cachedTop;
+      Event* freeList;
+      std::vector<Event*> chunks;
+
+      static bool before(Event const* a, Event const* b);
+      size_t bucketOf(Time) const;
+      void setPosition(Time);
+      void link(Event*);
+      void unlink(Event*);
+      void resize(size_t newBucketCount);
+      Event* allocate();
+      void release(Event*);
+
+      CalendarQueue(CalendarQueue const&); // not implemented
+      CalendarQueue& operator=(CalendarQueue const&); // not implemented
+
+    public:
+      CalendarQueue();
+      ~CalendarQueue();
+      Event* insert(Time, Node, BasicState*);
+      void erase(Event*);
+      // earliest event or NULL
+      Event* top();
+      bool empty() const;
+      size_t size() const;
+      size_t bucketCount() const;
+  };
+}
@@ -2,9 +2,7 @@
 
 #include "net/EventSearcher.h"
 
-#include "net/TimeEvent.h"
-
-#include <map>
+#include "net/CalendarQueue.h"
 
 namespace net {
   class PacketCacheBase;
@@ -14,8 +12,7 @@ namespace net {
     private:
       PacketCacheBase* packetCache;
       CoojaInformationHandler& cih;
-      typedef std::map<Time, TimeEvent> CalQueue;
-      CalQueue calQueue;
+      CalendarQueue calQueue;
       bool removeState(BasicState*);
     public:
       CoojaSearcher(PacketCacheBase*);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "klee/Statistic.h"
+
+namespace net {
+  namespace stats {
+
+    /// Distributed scenarios that terminated with consistent constraints.
+    extern klee::Statistic dscenarios;
+    /// Distributed scenarios removed from the state mapper.
+    extern klee::Statistic truncatedDScenarios;
+    /// State clusters that have been formed so far.
+    extern klee::Statistic clusters;
+    extern klee::Statistic transmissions;
+    extern klee::Statistic pullRequests;
+    /// Mappings the packet cache avoided because they were redundant.
+    extern klee::Statistic knownRedundantMappings;
+
+    /// Wall times in microseconds. They are inclusive, e.g. the time spent
+    /// committing mappings contains the time spent mapping and transmitting.
+    extern klee::Statistic mapTime;
+    extern klee::Statistic explodeTime;
+    extern klee::Statistic commitMappingsTime;
+    extern klee::Statistic transferConstraintsTime;
+    extern klee::Statistic transmitTime;
+
+  }
+}
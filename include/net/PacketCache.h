@@ -3,6 +3,7 @@
 #include "net/Node.h"
 #include "net/DataAtom.h"
 #include "net/TransmitHandler.h"
+#include "net/TraceRecorder.h"
 
 #include "net/util/Functor.h"
 #include "net/util/SharedPtr.h"
@@ -106,9 +107,17 @@ namespace net {
         , transmitHandler(transmitHandler) {
       }
       void cacheMapping(BasicState* sender, PacketInfo pi, ExData const& data) {
+        TraceRecorder::Scope scope;
+        if (TraceRecorder* const recorder = TraceRecorder::active())
+          if (scope.outermost())
+            recorder->cache(sender, static_cast<Node>(pi), data);
         PacketCacheBase::cacheMapping(sender,packets[pi],data);
       }
       void commitMappings() {
+        TraceRecorder::Scope scope;
+        if (TraceRecorder* const recorder = TraceRecorder::active())
+          if (scope.outermost())
+            recorder->commit();
         struct PiTransmitter : Transmitter {
           private:
             TxHnd const& transmitHandler;
@@ -40,7 +40,8 @@ namespace net {
   struct StateMapperInitialiser {
     public:
       bool const phonyPackets;
-      StateMapperInitialiser(bool phonyPackets);
+      bool const lazyExplosions;
+      StateMapperInitialiser(bool phonyPackets, bool lazyExplosions = false);
   };
 
   /****************************************************************************
@@ -193,10 +194,19 @@ namespace net {
         virtual void operator()(BasicState&,std::vector<BasicState*> const&) const = 0;
       };
       /// Transitively remove everything that belongs to the same cluster as the passed state.
+      /// With lazy explosions, the dscenarios are peeled off and terminated one
+      /// at a time instead of exploding all of them up front; only the states
+      /// of the current dscenario and the forks it leaves behind exist at once.
       /// \param state The pivotal state to figure out which cluster to finish.
       /// \param TerminateStateHandler Functor that will allow implementation specific termination of states.
       /// \returns true iff it knew that state (and by extension its cluster). In any case afterwards the state will be unknown.
       /*final*/ bool terminateCluster(BasicState& state, TerminateStateHandler const&); // <3 λ
+    private:
+      /// Make the dscenario of 'state' unique without exploding the other
+      /// dscenarios it shares states with. Used by lazy cluster termination.
+      void isolate(BasicState* state);
+      bool terminateClusterLazily(BasicState& state, TerminateStateHandler const&);
+    public:
 
       /// Call to find all states that are currently reachable from a given
       /// state.
@@ -250,7 +260,8 @@ namespace net {
       /*final*/ static StateMapper* create(
           StateMappingType mt,
           bool usePhonyPackets,
-          BasicState* rootState);
+          BasicState* rootState,
+          bool lazyExplosions = false);
 
       virtual void dumpInternals() const {}
   };
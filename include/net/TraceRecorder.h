@@ -0,0 +1,64 @@
+#pragma once
+
+#include "net/Node.h"
+#include "net/DataAtom.h"
+
+#include <map>
+#include <stdio.h>
+
+namespace net {
+  class BasicState;
+
+  /// Protocols what the engine asks of the net library, so that tools/net-bench
+  /// can replay the run without executing anything symbolically.
+  /// The trace is a text file with one event per line:
+  ///   root <s>                 the mapper was created with root state s
+  ///   branch <s>               the engine copied state s
+  ///   node <s> <n>             state s was assigned to node n
+  ///   cache <s> <n> <atom>*    s sends a packet to n (atoms: id, '*' if distinct)
+  ///   commit                   the packet cache was committed
+  ///   find <s> <n>             targets of s on node n were looked up
+  ///   terminate <s>            the cluster of s was terminated
+  /// States are numbered in the order they are created, which includes the
+  /// states the mapper forks itself. Only the outermost call into the library
+  /// is recorded, everything it does internally will happen again on replay.
+  /// Note that the recorder holds on to every data atom it has seen.
+  class TraceRecorder {
+    private:
+      FILE* const file;
+      unsigned nextId;
+      std::map<BasicState const*,unsigned> ids;
+      std::map<DataAtomHolder,unsigned> atoms;
+      static TraceRecorder*& activeRecorder();
+      static unsigned& depth();
+      explicit TraceRecorder(FILE*);
+      bool known(BasicState const*) const;
+      unsigned id(BasicState const*) const;
+    public:
+      ~TraceRecorder();
+      /// \returns false if the trace file cannot be written.
+      static bool start(char const* path);
+      static void stop();
+      /// The running recorder, or NULL.
+      static TraceRecorder* active() {
+        return activeRecorder();
+      }
+
+      /// Opened by every entry point of the library and by the copy-ctor of
+      /// BasicState. Events are only recorded in the outermost scope.
+      class Scope {
+        public:
+          Scope() { ++depth(); }
+          ~Scope() { --depth(); }
+          bool outermost() const { return depth() == 1; }
+      };
+
+      void created(BasicState const* parent, BasicState const* state);
+      void destroyed(BasicState const* state);
+      void node(BasicState const* state, Node n);
+      void cache(BasicState const* sender, Node dest, ExData const& data);
+      void commit();
+      void find(BasicState const* state, Node dest);
+      void terminate(BasicState const* state);
+  };
+}
@@ -36,6 +36,14 @@ UseIndependentSolver("use-independent-solver",
                      llvm::cl::init(true),
                      llvm::cl::desc("Use constraint independence (default=on)"));
 
+llvm::cl::opt<std::string>
+PersistentCacheFile("persistent-query-cache",
+                    llvm::cl::init(""),
+                    llvm::cl::value_desc("path"),
+                    llvm::cl::desc("Keep the results of queries reaching the core solver in this file "
+                                   "and reuse them across runs. Runs in parallel may share the file "
+                                   "(default=off)"));
+
 llvm::cl::opt<bool>
 DebugValidateSolver("debug-validate-solver",
 		             llvm::cl::init(false));
@@ -37,6 +37,12 @@ Solver *constructSolverChain(Solver *coreSolver,
                  baseSolverQuerySMT2LogPath.c_str());
   }
 
+  if (!PersistentCacheFile.empty()) {
+    solver = createPersistentCachingSolver(solver, PersistentCacheFile);
+    klee_message("Using persistent query cache %s\n",
+                 PersistentCacheFile.c_str());
+  }
+
   if (UseFastCexSolver)
     solver = createFastCexSolver(solver);
 
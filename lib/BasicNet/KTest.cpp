@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "klee/Internal/ADT/KTest.h"
+#include "KTestStream.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -78,23 +79,6 @@ extern "C" {
 /***/
 
 
-static int read_uint32(FILE *f, unsigned *value_out) {
-  unsigned char data[4];
-  if (fread(data, 4, 1, f)!=1)
-    return 0;
-  *value_out = (((((data[0]<<8) + data[1])<<8) + data[2])<<8) + data[3];
-  return 1;
-}
-
-static int write_uint32(FILE *f, unsigned value) {
-  unsigned char data[4];
-  data[0] = value>>24;
-  data[1] = value>>16;
-  data[2] = value>> 8;
-  data[3] = value>> 0;
-  return fwrite(data, 1, 4, f)==4;
-}
-
 static int read_string(FILE *f, char **value_out) {
   unsigned len;
   if (!read_uint32(f, &len))
@@ -150,11 +134,20 @@ int kTest_isKTestFile(const char *path) {
 KTest *kTest_fromFile(const char *path) {
   FILE *f = fopen(path, "rb");
   KTest *res = 0;
+
+  if (!f)
+    return 0;
+  res = kTest_fromStream(f);
+  fclose(f);
+
+  return res;
+}
+
+KTest *kTest_fromStream(FILE *f) {
+  KTest *res = 0;
   KnTest *knTest = 0;
   unsigned i, version;
 
-  if (!f) 
-    goto error;
   if (!kTest_checkHeader(f)) 
     goto error;
 
@@ -214,8 +207,6 @@ KTest *kTest_fromFile(const char *path) {
     goto error;
   /* EOF KleeNet stuff */
 
-  fclose(f);
-
   return res;
  error:
   if (res) {
@@ -235,21 +226,30 @@ KTest *kTest_fromFile(const char *path) {
       }
       free(res->objects);
     }
-    free(res);
+    free(static_cast_KnTest(res)->err);
+    free(static_cast_KnTest(res));
   }
 
-  if (f) fclose(f);
-
   return 0;
 }
 
 int kTest_toFile(KTest *bo, const char *path) {
   FILE *f = fopen(path, "wb");
+  int res;
+
+  if (!f)
+    return 0;
+  res = kTest_toStream(bo, f);
+  if (fclose(f))
+    res = 0;
+
+  return res;
+}
+
+int kTest_toStream(KTest *bo, FILE *f) {
   KnTest const* knTest = 0;
   unsigned i;
 
-  if (!f) 
-    goto error;
   if (fwrite(KTEST_MAGIC, strlen(KTEST_MAGIC), 1, f)!=1)
     goto error;
   if (!write_uint32(f, KTEST_VERSION))
@@ -290,12 +290,8 @@ int kTest_toFile(KTest *bo, const char *path) {
     goto error;
   /* EOF KleeNet stuff */
 
-  fclose(f);
-
   return 1;
  error:
-  if (f) fclose(f);
-  
   return 0;
 }
 
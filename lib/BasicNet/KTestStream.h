@@ -0,0 +1,42 @@
+//===-- KTestStream.h -------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "klee/Internal/ADT/KTest.h"
+
+#include <stdio.h>
+
+/* Shared between the single-file format and the archive. Numbers are
+ * stored big-endian. */
+
+static inline int read_uint32(FILE *f, unsigned *value_out) {
+  unsigned char data[4];
+  if (fread(data, 4, 1, f)!=1)
+    return 0;
+  *value_out = (((((data[0]<<8) + data[1])<<8) + data[2])<<8) + data[3];
+  return 1;
+}
+
+static inline int write_uint32(FILE *f, unsigned value) {
+  unsigned char data[4];
+  data[0] = value>>24;
+  data[1] = value>>16;
+  data[2] = value>> 8;
+  data[3] = value>> 0;
+  return fwrite(data, 1, 4, f)==4;
+}
+
+/* reads one complete test case (including its header) at the current
+ * position; returns NULL on (unspecified) error */
+KTest* kTest_fromStream(FILE *f);
+
+/* writes one complete test case (including its header) at the current
+ * position; returns 1 on success, 0 on (unspecified) error */
+int kTest_toStream(KTest *bo, FILE *f);
@@ -0,0 +1,251 @@
+//===-- KnTestArchive.cpp -------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Internal/ADT/KTest.h"
+#include "kleenet/KnTest.h"
+#include "kleenet/KnTestArchive.h"
+#include "KTestStream.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define KNARC_VERSION 1
+#define KNARC_MAGIC_SIZE 5
+#define KNARC_MAGIC "KNARC"
+#define KNARC_CHUNK_MAGIC "KNCHK"
+
+/* File layout:
+ *   "KNARC" version
+ *   chunk*
+ * chunk:
+ *   "KNCHK" count (id nodeId dscenarioId size){count} test-case{count}
+ */
+
+typedef struct KnTestArchiveEntry {
+  unsigned id;
+  unsigned nodeId;
+  unsigned dscenarioId;
+  unsigned size;
+} KnTestArchiveEntry;
+
+struct KnTestArchive {
+  FILE *file;
+  /* index of the current chunk */
+  KnTestArchiveEntry *entries;
+  unsigned numEntries;
+  unsigned capacity;
+  /* writing: test cases of the current chunk */
+  FILE *pending;
+  char *pendingData;
+  size_t pendingSize;
+  unsigned chunkSize;
+  /* reading: next entry of the current chunk, and the selection */
+  unsigned position;
+  int nodeId;
+  int dscenarioId;
+};
+
+static int knTestArchive_checkHeader(FILE *f) {
+  char header[KNARC_MAGIC_SIZE];
+  unsigned version;
+  if (fread(header, KNARC_MAGIC_SIZE, 1, f)!=1)
+    return 0;
+  if (memcmp(header, KNARC_MAGIC, KNARC_MAGIC_SIZE))
+    return 0;
+  if (!read_uint32(f, &version))
+    return 0;
+  return version <= KNARC_VERSION;
+}
+
+static KnTestArchive* knTestArchive_alloc(FILE *f) {
+  KnTestArchive *a = (KnTestArchive*) calloc(1, sizeof(KnTestArchive));
+  if (!a)
+    return 0;
+  a->file = f;
+  a->nodeId = -1;
+  a->dscenarioId = -1;
+  return a;
+}
+
+static int knTestArchive_reserve(KnTestArchive *a, unsigned n) {
+  KnTestArchiveEntry *entries;
+  if (n <= a->capacity)
+    return 1;
+  entries = (KnTestArchiveEntry*) realloc(a->entries, n * sizeof(*entries));
+  if (!entries)
+    return 0;
+  a->entries = entries;
+  a->capacity = n;
+  return 1;
+}
+
+/* the chunk is assembled in memory and handed to stdio in one piece */
+int knTestArchive_flush(KnTestArchive *a) {
+  unsigned i;
+  int ok = 1;
+  if (!a->pending || !a->numEntries)
+    return 1;
+  if (fflush(a->pending))
+    ok = 0;
+  ok = ok && fwrite(KNARC_CHUNK_MAGIC, KNARC_MAGIC_SIZE, 1, a->file)==1;
+  ok = ok && write_uint32(a->file, a->numEntries);
+  for (i=0; ok && i<a->numEntries; i++) {
+    KnTestArchiveEntry const *e = &a->entries[i];
+    ok = write_uint32(a->file, e->id) &&
+         write_uint32(a->file, e->nodeId) &&
+         write_uint32(a->file, e->dscenarioId) &&
+         write_uint32(a->file, e->size);
+  }
+  ok = ok && fwrite(a->pendingData, a->pendingSize, 1, a->file)==1;
+  ok = ok && !fflush(a->file);
+  a->numEntries = 0;
+  rewind(a->pending);
+  return ok;
+}
+
+int knTestArchive_isArchive(const char *path) {
+  FILE *f = fopen(path, "rb");
+  int res;
+
+  if (!f)
+    return 0;
+  res = knTestArchive_checkHeader(f);
+  fclose(f);
+
+  return res;
+}
+
+KnTestArchive* knTestArchive_create(const char *path, unsigned chunkSize) {
+  FILE *f = fopen(path, "wb");
+  KnTestArchive *a = 0;
+
+  if (!f)
+    goto error;
+  if (fwrite(KNARC_MAGIC, KNARC_MAGIC_SIZE, 1, f)!=1)
+    goto error;
+  if (!write_uint32(f, KNARC_VERSION))
+    goto error;
+  a = knTestArchive_alloc(f);
+  if (!a)
+    goto error;
+  a->chunkSize = chunkSize ? chunkSize : 1;
+  if (!knTestArchive_reserve(a, a->chunkSize))
+    goto error;
+  a->pending = open_memstream(&a->pendingData, &a->pendingSize);
+  if (!a->pending)
+    goto error;
+
+  return a;
+ error:
+  if (a) {
+    free(a->entries);
+    free(a);
+  }
+  if (f) fclose(f);
+
+  return 0;
+}
+
+int knTestArchive_append(KnTestArchive *a, KTest *bo, unsigned id) {
+  KnTestArchiveEntry *e;
+  long start;
+
+  if (!a->pending || (start = ftell(a->pending)) < 0)
+    return 0;
+  if (!kTest_toStream(bo, a->pending))
+    return 0;
+
+  e = &a->entries[a->numEntries++];
+  e->id = id;
+  e->nodeId = knTest_get_nodeId(bo);
+  e->dscenarioId = knTest_get_dscenarioId(bo);
+  e->size = (unsigned) (ftell(a->pending) - start);
+
+  if (a->numEntries == a->chunkSize)
+    return knTestArchive_flush(a);
+  return 1;
+}
+
+KnTestArchive* knTestArchive_open(const char *path) {
+  FILE *f = fopen(path, "rb");
+  KnTestArchive *a;
+
+  if (!f)
+    return 0;
+  if (!knTestArchive_checkHeader(f) || !(a = knTestArchive_alloc(f))) {
+    fclose(f);
+    return 0;
+  }
+
+  return a;
+}
+
+void knTestArchive_select(KnTestArchive *a, int nodeId, int dscenarioId) {
+  a->nodeId = nodeId;
+  a->dscenarioId = dscenarioId;
+}
+
+static int knTestArchive_readChunk(KnTestArchive *a) {
+  char header[KNARC_MAGIC_SIZE];
+  unsigned i, count;
+
+  a->numEntries = a->position = 0;
+  if (fread(header, KNARC_MAGIC_SIZE, 1, a->file)!=1)
+    return 0;
+  if (memcmp(header, KNARC_CHUNK_MAGIC, KNARC_MAGIC_SIZE))
+    return 0;
+  if (!read_uint32(a->file, &count) || !knTestArchive_reserve(a, count))
+    return 0;
+  for (i=0; i<count; i++) {
+    KnTestArchiveEntry *e = &a->entries[i];
+    if (!read_uint32(a->file, &e->id) ||
+        !read_uint32(a->file, &e->nodeId) ||
+        !read_uint32(a->file, &e->dscenarioId) ||
+        !read_uint32(a->file, &e->size))
+      return 0;
+  }
+  a->numEntries = count;
+  return 1;
+}
+
+KTest* knTestArchive_next(KnTestArchive *a, unsigned *id) {
+  for (;;) {
+    KnTestArchiveEntry const *e;
+    if (a->position == a->numEntries && !knTestArchive_readChunk(a))
+      return 0;
+    if (!a->numEntries)
+      continue;
+    e = &a->entries[a->position++];
+    if ((a->nodeId < 0 || (unsigned) a->nodeId == e->nodeId) &&
+        (a->dscenarioId < 0 || (unsigned) a->dscenarioId == e->dscenarioId)) {
+      if (id)
+        *id = e->id;
+      return kTest_fromStream(a->file);
+    }
+    if (fseek(a->file, e->size, SEEK_CUR))
+      return 0;
+  }
+}
+
+int knTestArchive_close(KnTestArchive *a) {
+  int ok = 1;
+
+  if (a->pending) {
+    ok = knTestArchive_flush(a);
+    fclose(a->pending);
+    free(a->pendingData);
+  }
+  if (fclose(a->file))
+    ok = 0;
+  free(a->entries);
+  free(a);
+
+  return ok;
+}
@@ -15,6 +15,8 @@
 #include "klee/Expr.h"
 #include "klee/TimerStatIncrementer.h"
 
+#include <algorithm>
+
 using namespace klee;
 
 ///
@@ -70,6 +72,111 @@ bool AddressSpace::resolveOne(const ref<ConstantExpr> &addr,
   return false;
 }
 
+namespace {
+  /// The first address after the object. Zero sized objects cover their
+  /// base address, as in MemoryObject::getBoundsCheckOffset.
+  ref<Expr> getEndExpr(const MemoryObject *mo) {
+    return ConstantExpr::create(mo->address + std::max(mo->size, 1u),
+                                Context::get().getPointerWidth());
+  }
+
+  /// The objects on one side of an example address, nearest first. Objects
+  /// are only taken from the map once the search reaches them, so walking
+  /// costs time in the number of objects within reach of the pointer rather
+  /// than in the number of objects in the address space.
+  class ObjectWalk {
+    MemoryMap::iterator it, stop;
+    bool downwards;
+    std::vector<const MemoryMap::value_type*> objs;
+
+  public:
+    /// Walk from the first object above the example either down to the
+    /// beginning of the map or up to its end.
+    ObjectWalk(const MemoryMap &objects, uint64_t example, bool downwards)
+      : it(objects.begin()), stop(objects.begin()), downwards(downwards) {
+      MemoryObject hack(example);
+      it = objects.upper_bound(&hack);
+      if (!downwards)
+        stop = objects.end();
+    }
+
+    /// \return true if there are more than i objects on this side.
+    bool reaches(unsigned i) {
+      while (objs.size() <= i && it != stop) {
+        if (downwards) {
+          --it;
+          objs.push_back(&*it);
+        } else {
+          objs.push_back(&*it);
+          ++it;
+        }
+      }
+      return i < objs.size();
+    }
+
+    unsigned size() const { return objs.size(); }
+
+    const MemoryMap::value_type &operator[](unsigned i) const {
+      return *objs[i];
+    }
+
+    /// Whether address may lie on the near side of the far boundary of the
+    /// object i, its end below the example or its base above it.
+    ref<Expr> mayReach(ref<Expr> address, unsigned i) const {
+      const MemoryObject *mo = objs[i]->first;
+      if (downwards)
+        return UltExpr::create(address, getEndExpr(mo));
+      return UgeExpr::create(address, mo->getBaseExpr());
+    }
+  };
+}
+
+/// Count the objects of walk that address may reach. These are a prefix of
+/// the walk, as objects further away from the example lie beyond the nearer
+/// ones. The search gallops away from the example and then bisects, so it
+/// needs a number of queries logarithmic in the number of objects in reach,
+/// where asking object by object needs one per object.
+///
+/// \return false if a query failed or timed out.
+static bool countInReach(ExecutionState &state, TimingSolver *solver,
+                         ref<Expr> address, ObjectWalk &walk,
+                         TimerStatIncrementer &timer, uint64_t timeout_us,
+                         unsigned &count) {
+  // the objects up to isTrue may be reached, those from isFalse on not
+  int isTrue = -1, isFalse;
+  for (unsigned step = 1;; step *= 2) {
+    int i = isTrue + step;
+    if (!walk.reaches(i)) {
+      i = int(walk.size()) - 1;
+      if (i == isTrue) {
+        isFalse = i + 1;
+        break;
+      }
+    }
+    if (timeout_us && timeout_us < timer.check())
+      return false;
+    bool mayBeTrue;
+    if (!solver->mayBeTrue(state, walk.mayReach(address, i), mayBeTrue))
+      return false;
+    if (!mayBeTrue) {
+      isFalse = i;
+      break;
+    }
+    isTrue = i;
+  }
+  while (isFalse - isTrue > 1) {
+    int const i = isTrue + (isFalse - isTrue) / 2;
+    if (timeout_us && timeout_us < timer.check())
+      return false;
+    bool mayBeTrue;
+    if (!solver->mayBeTrue(state, walk.mayReach(address, i), mayBeTrue))
+      return false;
+    (mayBeTrue ? isTrue : isFalse) = i;
+  }
+  count = isTrue + 1;
+  return true;
+}
+
 bool AddressSpace::resolveOne(ExecutionState &state,
                               TimingSolver *solver,
                               ref<Expr> address,
@@ -99,56 +206,24 @@ bool AddressSpace::resolveOne(ExecutionState &state,
       }
     }
 
-    // didn't work, now we have to search
-       
-    MemoryMap::iterator oi = objects.upper_bound(&hack);
-    MemoryMap::iterator begin = objects.begin();
-    MemoryMap::iterator end = objects.end();
-      
-    MemoryMap::iterator start = oi;
-    while (oi!=begin) {
-      --oi;
-      const MemoryObject *mo = oi->first;
-        
-      bool mayBeTrue;
-      if (!solver->mayBeTrue(state, 
-                             mo->getBoundsCheckPointer(address), mayBeTrue))
+    // didn't work, now we have to search, first below the example and then
+    // above it, nearest objects first
+
+    for (int downwards = 1; downwards >= 0; --downwards) {
+      ObjectWalk walk(objects, example, downwards);
+      unsigned count;
+      if (!countInReach(state, solver, address, walk, timer, 0, count))
         return false;
-      if (mayBeTrue) {
-        result = *oi;
-        success = true;
-        return true;
-      } else {
-        bool mustBeTrue;
-        if (!solver->mustBeTrue(state, 
-                                UgeExpr::create(address, mo->getBaseExpr()),
-                                mustBeTrue))
-          return false;
-        if (mustBeTrue)
-          break;
-      }
-    }
 
-    // search forwards
-    for (oi=start; oi!=end; ++oi) {
-      const MemoryObject *mo = oi->first;
+      for (unsigned i = 0; i != count; ++i) {
+        const MemoryObject *mo = walk[i].first;
 
-      bool mustBeTrue;
-      if (!solver->mustBeTrue(state, 
-                              UltExpr::create(address, mo->getBaseExpr()),
-                              mustBeTrue))
-        return false;
-      if (mustBeTrue) {
-        break;
-      } else {
         bool mayBeTrue;
-
         if (!solver->mayBeTrue(state, 
-                               mo->getBoundsCheckPointer(address),
-                               mayBeTrue))
+                               mo->getBoundsCheckPointer(address), mayBeTrue))
           return false;
         if (mayBeTrue) {
-          result = *oi;
+          result = walk[i];
           success = true;
           return true;
         }
@@ -181,102 +256,52 @@ bool AddressSpace::resolve(ExecutionState &state,
     // not the first, find a cex assuming not the second...
     // etc.
     
-    // XXX how do we smartly amortize the cost of checking to
-    // see if we need to keep searching up/down, in bad cases?
-    // maybe we don't care?
-    
-    // XXX we really just need a smart place to start (although
-    // if its a known solution then the code below is guaranteed
-    // to hit the fast path with exactly 2 queries). we could also
-    // just get this by inspection of the expr.
-    
     ref<ConstantExpr> cex;
     if (!solver->getValue(state, p, cex))
       return true;
     uint64_t example = cex->getZExtValue();
     MemoryObject hack(example);
-    
-    MemoryMap::iterator oi = objects.upper_bound(&hack);
-    MemoryMap::iterator begin = objects.begin();
-    MemoryMap::iterator end = objects.end();
-      
-    MemoryMap::iterator start = oi;
-      
-    // XXX in the common case we can save one query if we ask
-    // mustBeTrue before mayBeTrue for the first result. easy
-    // to add I just want to have a nice symbolic test case first.
-      
-    // search backwards, start with one minus because this
-    // is the object that p *should* be within, which means we
-    // get write off the end with 4 queries (XXX can be better,
-    // no?)
-    while (oi!=begin) {
-      --oi;
-      const MemoryObject *mo = oi->first;
-      if (timeout_us && timeout_us < timer.check())
-        return true;
+    const MemoryMap::value_type *res = objects.lookup_previous(&hack);
 
-      // XXX I think there is some query wasteage here?
-      ref<Expr> inBounds = mo->getBoundsCheckPointer(p);
-      bool mayBeTrue;
-      if (!solver->mayBeTrue(state, inBounds, mayBeTrue))
-        return true;
-      if (mayBeTrue) {
-        rl.push_back(*oi);
-        
-        // fast path check
-        unsigned size = rl.size();
-        if (size==1) {
-          bool mustBeTrue;
-          if (!solver->mustBeTrue(state, inBounds, mustBeTrue))
-            return true;
-          if (mustBeTrue)
-            return false;
-        } else if (size==maxResolutions) {
-          return true;
-        }
-      }
-        
+    // fast path, the pointer cannot leave the object of the example
+    const MemoryObject *exampleMo = res ? res->first : 0;
+    bool inExampleMo = exampleMo &&
+      ((exampleMo->size == 0 && example == exampleMo->address) ||
+       example - exampleMo->address < exampleMo->size);
+    if (inExampleMo) {
       bool mustBeTrue;
-      if (!solver->mustBeTrue(state, 
-                              UgeExpr::create(p, mo->getBaseExpr()),
+      if (!solver->mustBeTrue(state, exampleMo->getBoundsCheckPointer(p),
                               mustBeTrue))
         return true;
-      if (mustBeTrue)
-        break;
+      if (mustBeTrue) {
+        rl.push_back(*res);
+        return false;
+      }
     }
-    // search forwards
-    for (oi=start; oi!=end; ++oi) {
-      const MemoryObject *mo = oi->first;
-      if (timeout_us && timeout_us < timer.check())
-        return true;
 
-      bool mustBeTrue;
-      if (!solver->mustBeTrue(state, 
-                              UltExpr::create(p, mo->getBaseExpr()),
-                              mustBeTrue))
-        return true;
-      if (mustBeTrue)
-        break;
-      
-      // XXX I think there is some query wasteage here?
-      ref<Expr> inBounds = mo->getBoundsCheckPointer(p);
-      bool mayBeTrue;
-      if (!solver->mayBeTrue(state, inBounds, mayBeTrue))
+    // otherwise only visit the objects in reach of the pointer, first below
+    // the example and then above it, nearest objects first
+
+    for (int downwards = 1; downwards >= 0; --downwards) {
+      ObjectWalk walk(objects, example, downwards);
+      unsigned count;
+      if (!countInReach(state, solver, p, walk, timer, timeout_us, count))
         return true;
-      if (mayBeTrue) {
-        rl.push_back(*oi);
-        
-        // fast path check
-        unsigned size = rl.size();
-        if (size==1) {
-          bool mustBeTrue;
-          if (!solver->mustBeTrue(state, inBounds, mustBeTrue))
-            return true;
-          if (mustBeTrue)
-            return false;
-        } else if (size==maxResolutions) {
+
+      for (unsigned i = 0; i != count; ++i) {
+        const MemoryObject *mo = walk[i].first;
+        if (timeout_us && timeout_us < timer.check())
+          return true;
+
+        bool mayBeTrue = inExampleMo && mo == exampleMo;
+        if (!mayBeTrue &&
+            !solver->mayBeTrue(state, mo->getBoundsCheckPointer(p), mayBeTrue))
           return true;
+        if (mayBeTrue) {
+          rl.push_back(walk[i]);
+          // the objects above the example have not been looked at yet
+          if (rl.size() == maxResolutions)
+            return downwards || i + 1 != count;
         }
       }
     }
@@ -301,7 +326,7 @@ void AddressSpace::copyOutConcretes() {
       uint8_t *address = (uint8_t*) (unsigned long) mo->address;
 
       if (!os->readOnly)
-        memcpy(address, os->concreteStore, mo->size);
+        os->concreteStore.read(address);
     }
   }
 }
@@ -315,12 +340,12 @@ bool AddressSpace::copyInConcretes() {
       const ObjectState *os = it->second;
       uint8_t *address = (uint8_t*) (unsigned long) mo->address;
 
-      if (memcmp(address, os->concreteStore, mo->size)!=0) {
+      if (!os->concreteStore.equals(address)) {
         if (os->readOnly) {
           return false;
         } else {
           ObjectState *wos = getWriteable(mo, os);
-          memcpy(wos->concreteStore, address, mo->size);
+          wos->concreteStore.assign(address);
         }
       }
     }
@@ -348,7 +348,8 @@ Executor::Executor(LLVMContext &ctx, const InterpreterOptions &opts,
     : Interpreter(opts), kmodule(0), interpreterHandler(ih), searcher(0),
       externalDispatcher(new ExternalDispatcher(ctx)), statsTracker(0),
       pathWriter(0), symPathWriter(0), specialFunctionHandler(0),
-      processTree(0), replayKTest(0), replayPath(0), usingSeeds(0),
+      processTree(0), replayKTest(0), replayPath(0), shardIndex(0),
+      shardBegin(0), shardEnd(1), shardLog(0), usingSeeds(0),
       atMemoryLimit(false), inhibitForking(false), haltExecution(false),
       ivcEnabled(false),
       coreSolverTimeout(MaxCoreSolverTime != 0 && MaxInstructionTime != 0
@@ -455,6 +456,7 @@ Executor::~Executor() {
   if (debugInstFile) {
     delete debugInstFile;
   }
+  delete shardLog;
 }
 
 /***/
@@ -694,6 +696,54 @@ void Executor::initializeGlobals(ExecutionState &state) {
   }
 }
 
+void Executor::setShard(unsigned index, unsigned count) {
+  assert(index < count && "shard index out of range");
+  // a timeout terminates a path in one shard that another one follows on
+  if (count > 1 && coreSolverTimeout)
+    klee_error("sharding cannot be combined with --max-solver-time or "
+               "--max-instruction-time");
+  shardIndex = index;
+  shardBegin = 0;
+  shardEnd = count;
+  delete shardLog;
+  shardLog = count > 1 ? interpreterHandler->openOutputFile("shard-splits.txt")
+                       : 0;
+}
+
+unsigned Executor::splitShard(const ExecutionState &state,
+                              const std::vector< ref<Expr> > &conditions,
+                              unsigned &count) {
+  unsigned const n = conditions.size();
+  unsigned const size = shardEnd - shardBegin;
+  if (size <= 1 || !isShardable(state)) {
+    count = n;
+    return 0;
+  }
+  // All shards of the range took the same path so far, so they have to
+  // split at the same instruction on the same conditions. Log both for the
+  // coordinator to compare.
+  if (shardLog) {
+    unsigned fingerprint = state.prevPC->info->id;
+    for (unsigned i = 0; i < n; ++i)
+      fingerprint = fingerprint * 31 + conditions[i]->hash();
+    *shardLog << shardBegin << " " << shardEnd << " " << n << " "
+              << fingerprint << "\n";
+    shardLog->flush();
+  }
+  // Part j covers shard indices [begin + j*size/parts, begin + (j+1)*size/parts).
+  // If there are more alternatives than shards, every part is a single
+  // shard and the last one takes all remaining alternatives.
+  unsigned const parts = std::min(n, size);
+  unsigned j = 0;
+  while (shardBegin + (j + 1) * size / parts <= shardIndex)
+    ++j;
+  unsigned const begin = shardBegin + j * size / parts;
+  shardEnd = shardBegin + (j + 1) * size / parts;
+  shardBegin = begin;
+  count = (j == parts - 1) ? n - j : 1;
+  return j;
+}
+
 void Executor::branch(ExecutionState &state, 
                       const std::vector< ref<Expr> > &conditions,
                       std::vector<ExecutionState*> &result) {
@@ -711,12 +761,16 @@ void Executor::branch(ExecutionState &state,
       }
     }
   } else {
-    stats::forks += N-1;
+    // alternatives outside [first, first+count) belong to other shards
+    unsigned count;
+    unsigned const first = splitShard(state, conditions, count);
+    stats::forks += count-1;
 
+    result.assign(first, NULL);
     // XXX do proper balance or keep random?
     result.push_back(&state);
-    for (unsigned i=1; i<N; ++i) {
-      ExecutionState *es = result[theRNG.getInt32() % i];
+    for (unsigned i=first+1; i<first+count; ++i) {
+      ExecutionState *es = result[first + theRNG.getInt32() % (i - first)];
       ExecutionState *ns = es->branch();
       addedStates.push_back(ns);
       result.push_back(ns);
@@ -726,6 +780,7 @@ void Executor::branch(ExecutionState &state,
       ns->ptreeNode = res.first;
       es->ptreeNode = res.second;
     }
+    result.resize(N, NULL);
   }
 
   // If necessary redistribute seeds to match conditions, killing
@@ -871,6 +926,19 @@ Executor::fork(ExecutionState &current, ref<Expr> condition, bool isInternal) {
           addConstraint(current, Expr::createIsZero(condition));
           res = Solver::False;
         }
+      } else if (shardEnd - shardBegin > 1 && isShardable(current)) {
+        // the other side is explored by other shards
+        std::vector< ref<Expr> > conditions;
+        conditions.push_back(condition);
+        conditions.push_back(Expr::createIsZero(condition));
+        unsigned count;
+        if (splitShard(current, conditions, count) == 0) {
+          res = Solver::True;
+          addConstraint(current, condition);
+        } else {
+          res = Solver::False;
+          addConstraint(current, conditions[1]);
+        }
       }
     }
   }
@@ -1125,12 +1193,12 @@ const Cell& Executor::eval(KInstruction *ki, unsigned index,
 
 void Executor::bindLocal(KInstruction *target, ExecutionState &state, 
                          ref<Expr> value) {
-  getDestCell(state, target).value = value;
+  getDestCell(state, target).bind(value);
 }
 
 void Executor::bindArgument(KFunction *kf, unsigned index, 
                             ExecutionState &state, ref<Expr> value) {
-  getArgumentCell(state, kf, index).value = value;
+  getArgumentCell(state, kf, index).bind(value);
 }
 
 ref<Expr> Executor::toUnique(const ExecutionState &state, 
@@ -1464,7 +1532,7 @@ void Executor::transferToBasicBlock(BasicBlock *dst, BasicBlock *src,
   KFunction *kf = state.stack.back().kf;
   unsigned entry = kf->basicBlockEntry[dst];
   state.pc = &kf->instructions[entry];
-  if (state.pc->inst->getOpcode() == Instruction::PHI) {
+  if (state.pc->opcode == Instruction::PHI) {
     PHINode *first = static_cast<PHINode*>(state.pc->inst);
     state.incomingBBIndex = first->getBasicBlockIndex(src);
   }
@@ -1531,7 +1599,7 @@ static inline const llvm::fltSemantics * fpWidthToSemantics(unsigned width) {
 
 void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   Instruction *i = ki->inst;
-  switch (i->getOpcode()) {
+  switch (ki->opcode) {
     // Control flow
   case Instruction::Ret: {
     ReturnInst *ri = cast<ReturnInst>(i);
@@ -1541,7 +1609,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     ref<Expr> result = ConstantExpr::alloc(0, Expr::Bool);
     
     if (!isVoidReturn) {
-      result = eval(ki, 0, state).value;
+      result = eval(ki, 0, state).value();
     }
     
     if (state.stack.size() <= 1) {
@@ -1565,7 +1633,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
         if (t != Type::getVoidTy(i->getContext())) {
           // may need to do coercion due to bitcasts
           Expr::Width from = result->getWidth();
-          Expr::Width to = getWidthForLLVMType(t);
+          Expr::Width to = kcaller->width;
             
           if (from != to) {
             CallSite cs = (isa<InvokeInst>(caller) ? CallSite(cast<InvokeInst>(caller)) : 
@@ -1630,7 +1698,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
       // FIXME: Find a way that we don't have this hidden dependency.
       assert(bi->getCondition() == bi->getOperand(0) &&
              "Wrong operand index!");
-      ref<Expr> cond = eval(ki, 0, state).value;
+      ref<Expr> cond = eval(ki, 0, state).value();
       Executor::StatePair branches = fork(state, cond, false);
 
       // NOTE: There is a hidden dependency here, markBranchVisited
@@ -1649,7 +1717,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
   case Instruction::Switch: {
     SwitchInst *si = cast<SwitchInst>(i);
-    ref<Expr> cond = eval(ki, 0, state).value;
+    ref<Expr> cond = eval(ki, 0, state).value();
     BasicBlock *bb = si->getParent();
 
     cond = toUnique(state, cond);
@@ -1802,7 +1870,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     arguments.reserve(numArgs);
 
     for (unsigned j=0; j<numArgs; ++j)
-      arguments.push_back(eval(ki, j+1, state).value);
+      arguments.push_back(eval(ki, j+1, state).value());
 
     if (f) {
       const FunctionType *fType = 
@@ -1849,7 +1917,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
       executeCall(state, ki, f, arguments);
     } else {
-      ref<Expr> v = eval(ki, 0, state).value;
+      ref<Expr> v = eval(ki, 0, state).value();
 
       ExecutionState *free = &state;
       bool hasInvalid = false, first = true;
@@ -1891,19 +1959,23 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
   case Instruction::PHI: {
 #if LLVM_VERSION_CODE >= LLVM_VERSION(3, 0)
-    ref<Expr> result = eval(ki, state.incomingBBIndex, state).value;
+    getDestCell(state, ki) = eval(ki, state.incomingBBIndex, state);
 #else
-    ref<Expr> result = eval(ki, state.incomingBBIndex * 2, state).value;
+    getDestCell(state, ki) = eval(ki, state.incomingBBIndex * 2, state);
 #endif
-    bindLocal(ki, state, result);
     break;
   }
 
     // Special instructions
   case Instruction::Select: {
-    ref<Expr> cond = eval(ki, 0, state).value;
-    ref<Expr> tExpr = eval(ki, 1, state).value;
-    ref<Expr> fExpr = eval(ki, 2, state).value;
+    const Cell &condCell = eval(ki, 0, state);
+    if (condCell.isSmallConstant()) {
+      getDestCell(state, ki) = eval(ki, condCell.getZExtValue() ? 1 : 2, state);
+      break;
+    }
+    ref<Expr> cond = condCell.value();
+    ref<Expr> tExpr = eval(ki, 1, state).value();
+    ref<Expr> fExpr = eval(ki, 2, state).value();
     ref<Expr> result = SelectExpr::create(cond, tExpr, fExpr);
     bindLocal(ki, state, result);
     break;
@@ -1916,103 +1988,153 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
     // Arithmetic / logical
 
   case Instruction::Add: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    bindLocal(ki, state, AddExpr::create(left, right));
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant())
+      bindLocalConstant(ki, state, left.getZExtValue() + right.getZExtValue(), left.getWidth());
+    else
+      bindLocal(ki, state, AddExpr::create(left.value(), right.value()));
     break;
   }
 
   case Instruction::Sub: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    bindLocal(ki, state, SubExpr::create(left, right));
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant())
+      bindLocalConstant(ki, state, left.getZExtValue() - right.getZExtValue(), left.getWidth());
+    else
+      bindLocal(ki, state, SubExpr::create(left.value(), right.value()));
     break;
   }
  
   case Instruction::Mul: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    bindLocal(ki, state, MulExpr::create(left, right));
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant())
+      bindLocalConstant(ki, state, left.getZExtValue() * right.getZExtValue(), left.getWidth());
+    else
+      bindLocal(ki, state, MulExpr::create(left.value(), right.value()));
     break;
   }
 
   case Instruction::UDiv: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    ref<Expr> result = UDivExpr::create(left, right);
-    bindLocal(ki, state, result);
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant() &&
+        right.getZExtValue())
+      bindLocalConstant(ki, state, left.getZExtValue() / right.getZExtValue(), left.getWidth());
+    else
+      bindLocal(ki, state, UDivExpr::create(left.value(), right.value()));
     break;
   }
 
   case Instruction::SDiv: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    ref<Expr> result = SDivExpr::create(left, right);
-    bindLocal(ki, state, result);
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant() &&
+        right.getZExtValue()) {
+      // INT_MIN / -1 overflows on the host, APInt wraps it around
+      uint64_t result;
+      if (right.getSExtValue() == -1)
+        result = 0 - left.getZExtValue();
+      else
+        result = left.getSExtValue() / right.getSExtValue();
+      bindLocalConstant(ki, state, result, left.getWidth());
+    } else {
+      bindLocal(ki, state, SDivExpr::create(left.value(), right.value()));
+    }
     break;
   }
 
   case Instruction::URem: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    ref<Expr> result = URemExpr::create(left, right);
-    bindLocal(ki, state, result);
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant() &&
+        right.getZExtValue())
+      bindLocalConstant(ki, state, left.getZExtValue() % right.getZExtValue(), left.getWidth());
+    else
+      bindLocal(ki, state, URemExpr::create(left.value(), right.value()));
     break;
   }
  
   case Instruction::SRem: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    ref<Expr> result = SRemExpr::create(left, right);
-    bindLocal(ki, state, result);
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant() &&
+        right.getZExtValue()) {
+      // INT_MIN % -1 overflows on the host
+      uint64_t result;
+      if (right.getSExtValue() == -1)
+        result = 0;
+      else
+        result = left.getSExtValue() % right.getSExtValue();
+      bindLocalConstant(ki, state, result, left.getWidth());
+    } else {
+      bindLocal(ki, state, SRemExpr::create(left.value(), right.value()));
+    }
     break;
   }
 
   case Instruction::And: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    ref<Expr> result = AndExpr::create(left, right);
-    bindLocal(ki, state, result);
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant())
+      bindLocalConstant(ki, state, left.getZExtValue() & right.getZExtValue(), left.getWidth());
+    else
+      bindLocal(ki, state, AndExpr::create(left.value(), right.value()));
     break;
   }
 
   case Instruction::Or: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    ref<Expr> result = OrExpr::create(left, right);
-    bindLocal(ki, state, result);
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant())
+      bindLocalConstant(ki, state, left.getZExtValue() | right.getZExtValue(), left.getWidth());
+    else
+      bindLocal(ki, state, OrExpr::create(left.value(), right.value()));
     break;
   }
 
   case Instruction::Xor: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    ref<Expr> result = XorExpr::create(left, right);
-    bindLocal(ki, state, result);
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant())
+      bindLocalConstant(ki, state, left.getZExtValue() ^ right.getZExtValue(), left.getWidth());
+    else
+      bindLocal(ki, state, XorExpr::create(left.value(), right.value()));
     break;
   }
 
   case Instruction::Shl: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    ref<Expr> result = ShlExpr::create(left, right);
-    bindLocal(ki, state, result);
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant() &&
+        right.getZExtValue() < left.getWidth())
+      bindLocalConstant(ki, state, left.getZExtValue() << right.getZExtValue(), left.getWidth());
+    else
+      bindLocal(ki, state, ShlExpr::create(left.value(), right.value()));
     break;
   }
 
   case Instruction::LShr: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    ref<Expr> result = LShrExpr::create(left, right);
-    bindLocal(ki, state, result);
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant() &&
+        right.getZExtValue() < left.getWidth())
+      bindLocalConstant(ki, state, left.getZExtValue() >> right.getZExtValue(), left.getWidth());
+    else
+      bindLocal(ki, state, LShrExpr::create(left.value(), right.value()));
     break;
   }
 
   case Instruction::AShr: {
-    ref<Expr> left = eval(ki, 0, state).value;
-    ref<Expr> right = eval(ki, 1, state).value;
-    ref<Expr> result = AShrExpr::create(left, right);
-    bindLocal(ki, state, result);
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+    if (left.isSmallConstant() && right.isSmallConstant() &&
+        right.getZExtValue() < left.getWidth())
+      bindLocalConstant(ki, state, left.getSExtValue() >> right.getZExtValue(), left.getWidth());
+    else
+      bindLocal(ki, state, AShrExpr::create(left.value(), right.value()));
     break;
   }
 
@@ -2021,84 +2143,107 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::ICmp: {
     CmpInst *ci = cast<CmpInst>(i);
     ICmpInst *ii = cast<ICmpInst>(ci);
- 
+    const Cell &left = eval(ki, 0, state);
+    const Cell &right = eval(ki, 1, state);
+
+    if (left.isSmallConstant() && right.isSmallConstant()) {
+      bool result;
+      switch(ii->getPredicate()) {
+      case ICmpInst::ICMP_EQ:
+        result = left.getZExtValue() == right.getZExtValue();
+        break;
+      case ICmpInst::ICMP_NE:
+        result = left.getZExtValue() != right.getZExtValue();
+        break;
+      case ICmpInst::ICMP_UGT:
+        result = left.getZExtValue() > right.getZExtValue();
+        break;
+      case ICmpInst::ICMP_UGE:
+        result = left.getZExtValue() >= right.getZExtValue();
+        break;
+      case ICmpInst::ICMP_ULT:
+        result = left.getZExtValue() < right.getZExtValue();
+        break;
+      case ICmpInst::ICMP_ULE:
+        result = left.getZExtValue() <= right.getZExtValue();
+        break;
+      case ICmpInst::ICMP_SGT:
+        result = left.getSExtValue() > right.getSExtValue();
+        break;
+      case ICmpInst::ICMP_SGE:
+        result = left.getSExtValue() >= right.getSExtValue();
+        break;
+      case ICmpInst::ICMP_SLT:
+        result = left.getSExtValue() < right.getSExtValue();
+        break;
+      case ICmpInst::ICMP_SLE:
+        result = left.getSExtValue() <= right.getSExtValue();
+        break;
+      default:
+        terminateStateOnExecError(state, "invalid ICmp predicate");
+        return;
+      }
+      bindLocalConstant(ki, state, result, Expr::Bool);
+      break;
+    }
+
     switch(ii->getPredicate()) {
     case ICmpInst::ICMP_EQ: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
-      ref<Expr> result = EqExpr::create(left, right);
+      ref<Expr> result = EqExpr::create(left.value(), right.value());
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_NE: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
-      ref<Expr> result = NeExpr::create(left, right);
+      ref<Expr> result = NeExpr::create(left.value(), right.value());
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_UGT: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
-      ref<Expr> result = UgtExpr::create(left, right);
-      bindLocal(ki, state,result);
+      ref<Expr> result = UgtExpr::create(left.value(), right.value());
+      bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_UGE: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
-      ref<Expr> result = UgeExpr::create(left, right);
+      ref<Expr> result = UgeExpr::create(left.value(), right.value());
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_ULT: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
-      ref<Expr> result = UltExpr::create(left, right);
+      ref<Expr> result = UltExpr::create(left.value(), right.value());
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_ULE: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
-      ref<Expr> result = UleExpr::create(left, right);
+      ref<Expr> result = UleExpr::create(left.value(), right.value());
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_SGT: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
-      ref<Expr> result = SgtExpr::create(left, right);
+      ref<Expr> result = SgtExpr::create(left.value(), right.value());
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_SGE: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
-      ref<Expr> result = SgeExpr::create(left, right);
+      ref<Expr> result = SgeExpr::create(left.value(), right.value());
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_SLT: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
-      ref<Expr> result = SltExpr::create(left, right);
+      ref<Expr> result = SltExpr::create(left.value(), right.value());
       bindLocal(ki, state, result);
       break;
     }
 
     case ICmpInst::ICMP_SLE: {
-      ref<Expr> left = eval(ki, 0, state).value;
-      ref<Expr> right = eval(ki, 1, state).value;
-      ref<Expr> result = SleExpr::create(left, right);
+      ref<Expr> result = SleExpr::create(left.value(), right.value());
       bindLocal(ki, state, result);
       break;
     }
@@ -2116,7 +2261,7 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
       kmodule->targetData->getTypeStoreSize(ai->getAllocatedType());
     ref<Expr> size = Expr::createPointer(elementSize);
     if (ai->isArrayAllocation()) {
-      ref<Expr> count = eval(ki, 0, state).value;
+      ref<Expr> count = eval(ki, 0, state).value();
       count = Expr::createZExtToPointerWidth(count);
       size = MulExpr::create(size, count);
     }
@@ -2125,26 +2270,45 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::Load: {
-    ref<Expr> base = eval(ki, 0, state).value;
+    ref<Expr> base = eval(ki, 0, state).value();
     executeMemoryOperation(state, false, base, 0, ki);
     break;
   }
   case Instruction::Store: {
-    ref<Expr> base = eval(ki, 1, state).value;
-    ref<Expr> value = eval(ki, 0, state).value;
+    ref<Expr> base = eval(ki, 1, state).value();
+    ref<Expr> value = eval(ki, 0, state).value();
     executeMemoryOperation(state, true, base, value, 0);
     break;
   }
 
   case Instruction::GetElementPtr: {
     KGEPInstruction *kgepi = static_cast<KGEPInstruction*>(ki);
-    ref<Expr> base = eval(ki, 0, state).value;
+    const Cell &baseCell = eval(ki, 0, state);
+
+    bool concrete = baseCell.isSmallConstant();
+    uint64_t address = concrete ? baseCell.getZExtValue() : 0;
+    for (std::vector< std::pair<unsigned, uint64_t> >::iterator 
+           it = kgepi->indices.begin(), ie = kgepi->indices.end(); 
+         concrete && it != ie; ++it) {
+      const Cell &index = eval(ki, it->first, state);
+      if (index.isSmallConstant())
+        address += uint64_t(index.getSExtValue()) * it->second;
+      else
+        concrete = false;
+    }
+    if (concrete) {
+      bindLocalConstant(ki, state, address + kgepi->offset,
+                        Context::get().getPointerWidth());
+      break;
+    }
+
+    ref<Expr> base = baseCell.value();
 
     for (std::vector< std::pair<unsigned, uint64_t> >::iterator 
            it = kgepi->indices.begin(), ie = kgepi->indices.end(); 
          it != ie; ++it) {
       uint64_t elementSize = it->second;
-      ref<Expr> index = eval(ki, it->first, state).value;
+      ref<Expr> index = eval(ki, it->first, state).value();
       base = AddExpr::create(base,
                              MulExpr::create(Expr::createSExtToPointerWidth(index),
                                              Expr::createPointer(elementSize)));
@@ -2158,55 +2322,68 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
     // Conversion
   case Instruction::Trunc: {
-    CastInst *ci = cast<CastInst>(i);
-    ref<Expr> result = ExtractExpr::create(eval(ki, 0, state).value,
-                                           0,
-                                           getWidthForLLVMType(ci->getType()));
+    const Cell &arg = eval(ki, 0, state);
+    if (arg.isSmallConstant()) {
+      bindLocalConstant(ki, state, arg.getZExtValue(), ki->width);
+      break;
+    }
+    ref<Expr> result = ExtractExpr::create(arg.value(), 0, ki->width);
     bindLocal(ki, state, result);
     break;
   }
   case Instruction::ZExt: {
-    CastInst *ci = cast<CastInst>(i);
-    ref<Expr> result = ZExtExpr::create(eval(ki, 0, state).value,
-                                        getWidthForLLVMType(ci->getType()));
+    Expr::Width width = ki->width;
+    const Cell &arg = eval(ki, 0, state);
+    if (arg.isSmallConstant() && width <= Expr::Int64) {
+      bindLocalConstant(ki, state, arg.getZExtValue(), width);
+      break;
+    }
+    ref<Expr> result = ZExtExpr::create(arg.value(), width);
     bindLocal(ki, state, result);
     break;
   }
   case Instruction::SExt: {
-    CastInst *ci = cast<CastInst>(i);
-    ref<Expr> result = SExtExpr::create(eval(ki, 0, state).value,
-                                        getWidthForLLVMType(ci->getType()));
+    Expr::Width width = ki->width;
+    const Cell &arg = eval(ki, 0, state);
+    if (arg.isSmallConstant() && width <= Expr::Int64) {
+      bindLocalConstant(ki, state, arg.getSExtValue(), width);
+      break;
+    }
+    ref<Expr> result = SExtExpr::create(arg.value(), width);
     bindLocal(ki, state, result);
     break;
   }
 
   case Instruction::IntToPtr: {
-    CastInst *ci = cast<CastInst>(i);
-    Expr::Width pType = getWidthForLLVMType(ci->getType());
-    ref<Expr> arg = eval(ki, 0, state).value;
-    bindLocal(ki, state, ZExtExpr::create(arg, pType));
+    Expr::Width pType = ki->width;
+    const Cell &arg = eval(ki, 0, state);
+    if (arg.isSmallConstant() && pType <= Expr::Int64)
+      bindLocalConstant(ki, state, arg.getZExtValue(), pType);
+    else
+      bindLocal(ki, state, ZExtExpr::create(arg.value(), pType));
     break;
   } 
   case Instruction::PtrToInt: {
-    CastInst *ci = cast<CastInst>(i);
-    Expr::Width iType = getWidthForLLVMType(ci->getType());
-    ref<Expr> arg = eval(ki, 0, state).value;
-    bindLocal(ki, state, ZExtExpr::create(arg, iType));
+    Expr::Width iType = ki->width;
+    const Cell &arg = eval(ki, 0, state);
+    if (arg.isSmallConstant() && iType <= Expr::Int64)
+      bindLocalConstant(ki, state, arg.getZExtValue(), iType);
+    else
+      bindLocal(ki, state, ZExtExpr::create(arg.value(), iType));
     break;
   }
 
   case Instruction::BitCast: {
-    ref<Expr> result = eval(ki, 0, state).value;
-    bindLocal(ki, state, result);
+    getDestCell(state, ki) = eval(ki, 0, state);
     break;
   }
 
     // Floating point instructions
 
   case Instruction::FAdd: {
-    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value,
+    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value(),
                                         "floating point");
-    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value,
+    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value(),
                                          "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
@@ -2224,9 +2401,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FSub: {
-    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value,
+    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value(),
                                         "floating point");
-    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value,
+    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value(),
                                          "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
@@ -2243,9 +2420,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
  
   case Instruction::FMul: {
-    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value,
+    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value(),
                                         "floating point");
-    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value,
+    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value(),
                                          "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
@@ -2263,9 +2440,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FDiv: {
-    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value,
+    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value(),
                                         "floating point");
-    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value,
+    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value(),
                                          "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
@@ -2283,9 +2460,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FRem: {
-    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value,
+    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value(),
                                         "floating point");
-    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value,
+    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value(),
                                          "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
@@ -2303,9 +2480,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FPTrunc: {
-    FPTruncInst *fi = cast<FPTruncInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
-    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
+    Expr::Width resultType = ki->width;
+    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value(),
                                        "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || resultType > arg->getWidth())
       return terminateStateOnExecError(state, "Unsupported FPTrunc operation");
@@ -2324,9 +2500,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FPExt: {
-    FPExtInst *fi = cast<FPExtInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
-    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
+    Expr::Width resultType = ki->width;
+    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value(),
                                         "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || arg->getWidth() > resultType)
       return terminateStateOnExecError(state, "Unsupported FPExt operation");
@@ -2344,9 +2519,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FPToUI: {
-    FPToUIInst *fi = cast<FPToUIInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
-    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
+    Expr::Width resultType = ki->width;
+    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value(),
                                        "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || resultType > 64)
       return terminateStateOnExecError(state, "Unsupported FPToUI operation");
@@ -2365,9 +2539,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::FPToSI: {
-    FPToSIInst *fi = cast<FPToSIInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
-    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
+    Expr::Width resultType = ki->width;
+    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value(),
                                        "floating point");
     if (!fpWidthToSemantics(arg->getWidth()) || resultType > 64)
       return terminateStateOnExecError(state, "Unsupported FPToSI operation");
@@ -2386,9 +2559,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::UIToFP: {
-    UIToFPInst *fi = cast<UIToFPInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
-    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
+    Expr::Width resultType = ki->width;
+    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value(),
                                        "floating point");
     const llvm::fltSemantics *semantics = fpWidthToSemantics(resultType);
     if (!semantics)
@@ -2402,9 +2574,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   }
 
   case Instruction::SIToFP: {
-    SIToFPInst *fi = cast<SIToFPInst>(i);
-    Expr::Width resultType = getWidthForLLVMType(fi->getType());
-    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value,
+    Expr::Width resultType = ki->width;
+    ref<ConstantExpr> arg = toConstant(state, eval(ki, 0, state).value(),
                                        "floating point");
     const llvm::fltSemantics *semantics = fpWidthToSemantics(resultType);
     if (!semantics)
@@ -2419,9 +2590,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
 
   case Instruction::FCmp: {
     FCmpInst *fi = cast<FCmpInst>(i);
-    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value,
+    ref<ConstantExpr> left = toConstant(state, eval(ki, 0, state).value(),
                                         "floating point");
-    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value,
+    ref<ConstantExpr> right = toConstant(state, eval(ki, 1, state).value(),
                                          "floating point");
     if (!fpWidthToSemantics(left->getWidth()) ||
         !fpWidthToSemantics(right->getWidth()))
@@ -2517,8 +2688,8 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::InsertValue: {
     KGEPInstruction *kgepi = static_cast<KGEPInstruction*>(ki);
 
-    ref<Expr> agg = eval(ki, 0, state).value;
-    ref<Expr> val = eval(ki, 1, state).value;
+    ref<Expr> agg = eval(ki, 0, state).value();
+    ref<Expr> val = eval(ki, 1, state).value();
 
     ref<Expr> l = NULL, r = NULL;
     unsigned lOffset = kgepi->offset*8, rOffset = kgepi->offset*8 + val->getWidth();
@@ -2544,9 +2715,9 @@ void Executor::executeInstruction(ExecutionState &state, KInstruction *ki) {
   case Instruction::ExtractValue: {
     KGEPInstruction *kgepi = static_cast<KGEPInstruction*>(ki);
 
-    ref<Expr> agg = eval(ki, 0, state).value;
+    ref<Expr> agg = eval(ki, 0, state).value();
 
-    ref<Expr> result = ExtractExpr::create(agg, kgepi->offset*8, getWidthForLLVMType(i->getType()));
+    ref<Expr> result = ExtractExpr::create(agg, kgepi->offset*8, ki->width);
 
     bindLocal(ki, state, result);
     break;
@@ -2656,7 +2827,7 @@ void Executor::bindModuleConstants() {
   kmodule->constantTable = new Cell[kmodule->constants.size()];
   for (unsigned i=0; i<kmodule->constants.size(); ++i) {
     Cell &c = kmodule->constantTable[i];
-    c.value = evalConstant(kmodule->constants[i]);
+    c.bind(evalConstant(kmodule->constants[i]));
   }
 }
 
@@ -2675,18 +2846,7 @@ void Executor::checkMemoryUsage() {
         // just guess at how many to kill
         unsigned numStates = states.size();
         unsigned toKill = std::max(1U, numStates - numStates * MaxMemory / mbs);
-        klee_warning("killing %d states (over memory cap)", toKill);
-        std::vector<ExecutionState *> arr(states.begin(), states.end());
-        for (unsigned i = 0, N = arr.size(); N && i < toKill; ++i, --N) {
-          unsigned idx = rand() % N;
-          // Make two pulls to try and not hit a state that
-          // covered new code.
-          if (arr[idx]->coveredNew)
-            idx = rand() % N;
-
-          std::swap(arr[idx], arr[N - 1]);
-          terminateStateEarly(*arr[N - 1], "Memory limit exceeded.");
-        }
+        killStatesOverMemoryCap(toKill);
       }
       atMemoryLimit = true;
     } else {
@@ -2695,6 +2855,21 @@ void Executor::checkMemoryUsage() {
   }
 }
 
+void Executor::killStatesOverMemoryCap(unsigned toKill) {
+  klee_warning("killing %d states (over memory cap)", toKill);
+  std::vector<ExecutionState *> arr(states.begin(), states.end());
+  for (unsigned i = 0, N = arr.size(); N && i < toKill; ++i, --N) {
+    unsigned idx = rand() % N;
+    // Make two pulls to try and not hit a state that
+    // covered new code.
+    if (arr[idx]->coveredNew)
+      idx = rand() % N;
+
+    std::swap(arr[idx], arr[N - 1]);
+    terminateStateEarly(*arr[N - 1], "Memory limit exceeded.");
+  }
+}
+
 void Executor::doDumpStates() {
   if (!DumpStatesOnHalt || states.empty())
     return;
@@ -3098,8 +3273,7 @@ void Executor::callExternalFunction(ExecutionState &state,
 
   LLVM_TYPE_Q Type *resultType = target->inst->getType();
   if (resultType != Type::getVoidTy(function->getContext())) {
-    ref<Expr> e = ConstantExpr::fromMemory((void*) args, 
-                                           getWidthForLLVMType(resultType));
+    ref<Expr> e = ConstantExpr::fromMemory((void*) args, target->width);
     bindLocal(target, state, e);
   }
 }
@@ -3325,8 +3499,7 @@ void Executor::executeMemoryOperation(ExecutionState &state,
                                       ref<Expr> address,
                                       ref<Expr> value /* undef if read */,
                                       KInstruction *target /* undef if write */) {
-  Expr::Width type = (isWrite ? value->getWidth() : 
-                     getWidthForLLVMType(target->inst->getType()));
+  Expr::Width type = (isWrite ? value->getWidth() : target->width);
   unsigned bytes = Expr::getMinBytesForWidth(type);
 
   if (SimplifySymIndices) {
@@ -165,6 +165,17 @@ protected: // KleeNet mod
   /// object.
   unsigned replayPosition;
 
+  /// The shard of the execution tree this process explores, see setShard().
+  /// While the range [shardBegin, shardEnd) of cooperating processes still
+  /// holds more than this one, every decision point splits the range among
+  /// its feasible alternatives and only the alternatives of the part that
+  /// contains shardIndex are followed.
+  unsigned shardIndex, shardBegin, shardEnd;
+
+  /// Records every split of the shard range, so that the coordinator can
+  /// check that the shards agreed on the decision points they split at.
+  llvm::raw_ostream *shardLog;
+
   /// When non-null a list of "seed" inputs which will be used to
   /// drive execution.
   const std::vector<struct KTest *> *usingSeeds;  
@@ -296,6 +307,20 @@ protected: // KleeNet mod
   void executeMakeSymbolic(ExecutionState &state, const MemoryObject *mo,
                            const std::string &name);
 
+  /// Splits the shard range at a decision point of state with the given
+  /// feasible alternatives. Returns the first alternative this process
+  /// follows and sets count to the number of consecutive alternatives it
+  /// follows.
+  unsigned splitShard(const ExecutionState &state,
+                      const std::vector< ref<Expr> > &conditions,
+                      unsigned &count);
+
+  /// Whether the decision points of state may split the shard range. If
+  /// not, every shard of the range follows all alternatives.
+  virtual bool isShardable(const ExecutionState &state) const {
+    return true;
+  }
+
   /// Create a new state where each input condition has been added as
   /// a constraint and return the results. The input state is included
   /// as one of the results. Note that the output vector may included
@@ -336,6 +361,14 @@ protected: // KleeNet mod
   void bindLocal(KInstruction *target, 
                  ExecutionState &state, 
                  ref<Expr> value);
+  /// Binds a concrete result of at most 64 bits without allocating an
+  /// expression for it.
+  void bindLocalConstant(KInstruction *target,
+                         ExecutionState &state,
+                         uint64_t value,
+                         Expr::Width width) {
+    getDestCell(state, target).bindConstant(value, width);
+  }
   void bindArgument(KFunction *kf, 
                     unsigned index,
                     ExecutionState &state,
@@ -423,6 +456,8 @@ protected: // KleeNet mod
   void processTimers(ExecutionState *current,
                      double maxInstTime);
   void checkMemoryUsage();
+  // terminate about toKill states to get back under the memory cap
+  void killStatesOverMemoryCap(unsigned toKill);
   void printDebugInstructions(ExecutionState &state);
   void doDumpStates();
 
@@ -460,6 +495,12 @@ public:
   virtual const llvm::Module *
   setModule(llvm::Module *module, const ModuleOptions &opts);
 
+  virtual void setShard(unsigned index, unsigned count);
+
+  virtual bool isShardRedundant() const {
+    return shardIndex != shardBegin;
+  }
+
   virtual void useSeeds(const std::vector<struct KTest *> *seeds) { 
     usingSeeds = seeds;
   }
@@ -42,6 +42,10 @@ namespace {
   cl::opt<bool>
   UseConstantArrays("use-constant-arrays",
                     cl::init(true));
+
+  bool isKnownSymbolic(const ref<Expr> &e) {
+    return !e.isNull();
+  }
 }
 
 /***/
@@ -102,7 +106,7 @@ ObjectState::ObjectState(const MemoryObject *mo)
   : copyOnWriteOwner(0),
     refCount(0),
     object(mo),
-    concreteStore(new uint8_t[mo->size]),
+    concreteStore(mo->size),
     concreteMask(0),
     flushMask(0),
     knownSymbolics(0),
@@ -116,7 +120,6 @@ ObjectState::ObjectState(const MemoryObject *mo)
         getArrayCache()->CreateArray("tmp_arr" + llvm::utostr(++id), size);
     updates = UpdateList(array, 0);
   }
-  memset(concreteStore, 0, size);
 }
 
 
@@ -124,7 +127,7 @@ ObjectState::ObjectState(const MemoryObject *mo, const Array *array)
   : copyOnWriteOwner(0),
     refCount(0),
     object(mo),
-    concreteStore(new uint8_t[mo->size]),
+    concreteStore(mo->size),
     concreteMask(0),
     flushMask(0),
     knownSymbolics(0),
@@ -133,38 +136,29 @@ ObjectState::ObjectState(const MemoryObject *mo, const Array *array)
     readOnly(false) {
   mo->refCount++;
   makeSymbolic();
-  memset(concreteStore, 0, size);
 }
 
 ObjectState::ObjectState(const ObjectState &os) 
   : copyOnWriteOwner(0),
     refCount(0),
     object(os.object),
-    concreteStore(new uint8_t[os.size]),
+    concreteStore(os.concreteStore),
     concreteMask(os.concreteMask ? new BitArray(*os.concreteMask, os.size) : 0),
     flushMask(os.flushMask ? new BitArray(*os.flushMask, os.size) : 0),
-    knownSymbolics(0),
+    knownSymbolics(os.knownSymbolics ?
+                   new PagedArray< ref<Expr> >(*os.knownSymbolics) : 0),
     updates(os.updates),
     size(os.size),
     readOnly(false) {
   assert(!os.readOnly && "no need to copy read only object?");
   if (object)
     object->refCount++;
-
-  if (os.knownSymbolics) {
-    knownSymbolics = new ref<Expr>[size];
-    for (unsigned i=0; i<size; i++)
-      knownSymbolics[i] = os.knownSymbolics[i];
-  }
-
-  memcpy(concreteStore, os.concreteStore, size*sizeof(*concreteStore));
 }
 
 ObjectState::~ObjectState() {
   if (concreteMask) delete concreteMask;
   if (flushMask) delete flushMask;
-  if (knownSymbolics) delete[] knownSymbolics;
-  delete[] concreteStore;
+  if (knownSymbolics) delete knownSymbolics;
 
   if (object)
   {
@@ -238,7 +232,7 @@ const UpdateList &ObjectState::getUpdates() const {
 void ObjectState::makeConcrete() {
   if (concreteMask) delete concreteMask;
   if (flushMask) delete flushMask;
-  if (knownSymbolics) delete[] knownSymbolics;
+  if (knownSymbolics) delete knownSymbolics;
   concreteMask = 0;
   flushMask = 0;
   knownSymbolics = 0;
@@ -258,15 +252,13 @@ void ObjectState::makeSymbolic() {
 
 void ObjectState::initializeToZero() {
   makeConcrete();
-  memset(concreteStore, 0, size);
+  concreteStore.fill(0, size, 0);
 }
 
 void ObjectState::initializeToRandom() {  
   makeConcrete();
-  for (unsigned i=0; i<size; i++) {
-    // randomly selected by 256 sided die
-    concreteStore[i] = 0xAB;
-  }
+  // randomly selected by 256 sided die
+  concreteStore.fill(0, size, 0xAB);
 }
 
 /*
@@ -296,7 +288,7 @@ void ObjectState::flushRangeForRead(unsigned rangeBase,
       } else {
         assert(isByteKnownSymbolic(offset) && "invalid bit set in flushMask");
         updates.extend(ConstantExpr::create(offset, Expr::Int32),
-                       knownSymbolics[offset]);
+                       (*knownSymbolics)[offset]);
       }
 
       flushMask->unset(offset);
@@ -317,7 +309,7 @@ void ObjectState::flushRangeForWrite(unsigned rangeBase,
       } else {
         assert(isByteKnownSymbolic(offset) && "invalid bit set in flushMask");
         updates.extend(ConstantExpr::create(offset, Expr::Int32),
-                       knownSymbolics[offset]);
+                       (*knownSymbolics)[offset]);
         setKnownSymbolic(offset, 0);
       }
 
@@ -343,7 +335,7 @@ bool ObjectState::isByteFlushed(unsigned offset) const {
 }
 
 bool ObjectState::isByteKnownSymbolic(unsigned offset) const {
-  return knownSymbolics && knownSymbolics[offset].get();
+  return knownSymbolics && (*knownSymbolics)[offset].get();
 }
 
 void ObjectState::markByteConcrete(unsigned offset) {
@@ -373,11 +365,13 @@ void ObjectState::markByteFlushed(unsigned offset) {
 void ObjectState::setKnownSymbolic(unsigned offset, 
                                    Expr *value /* can be null */) {
   if (knownSymbolics) {
-    knownSymbolics[offset] = value;
+    // do not unshare the page just to clear a byte that is not set
+    if (value || (*knownSymbolics)[offset].get())
+      knownSymbolics->getWriteable(offset) = value;
   } else {
     if (value) {
-      knownSymbolics = new ref<Expr>[size];
-      knownSymbolics[offset] = value;
+      knownSymbolics = new PagedArray< ref<Expr> >(size);
+      knownSymbolics->getWriteable(offset) = value;
     }
   }
 }
@@ -388,7 +382,7 @@ ref<Expr> ObjectState::read8(unsigned offset) const {
   if (isByteConcrete(offset)) {
     return ConstantExpr::create(concreteStore[offset], Expr::Int8);
   } else if (isByteKnownSymbolic(offset)) {
-    return knownSymbolics[offset];
+    return (*knownSymbolics)[offset];
   } else {
     assert(isByteFlushed(offset) && "unflushed byte without cache value");
     
@@ -416,7 +410,8 @@ ref<Expr> ObjectState::read8(ref<Expr> offset) const {
 
 void ObjectState::write8(unsigned offset, uint8_t value) {
   //assert(read_only == false && "writing to read-only object!");
-  concreteStore[offset] = value;
+  if (concreteStore[offset] != value)
+    concreteStore.getWriteable(offset) = value;
   setKnownSymbolic(offset, 0);
 
   markByteConcrete(offset);
@@ -583,6 +578,45 @@ void ObjectState::write64(unsigned offset, uint64_t value) {
   }
 }
 
+void ObjectState::write(unsigned offset, const uint8_t *values,
+                        unsigned count) {
+  assert(offset + count <= size && "Invalid bulk write range!");
+  concreteStore.write(offset, values, count);
+  if (knownSymbolics)
+    knownSymbolics->fill(offset, offset + count, ref<Expr>(), isKnownSymbolic);
+  if (concreteMask)
+    concreteMask->setRange(offset, offset + count);
+  if (flushMask)
+    flushMask->setRange(offset, offset + count);
+}
+
+void ObjectState::write(unsigned offset, const ref<Expr> *bytes,
+                        unsigned count) {
+  assert(offset + count <= size && "Invalid bulk write range!");
+  uint8_t run[256];
+  unsigned runBegin = 0, runSize = 0;
+  for (unsigned i = 0; i != count; ++i) {
+    assert(bytes[i]->getWidth() == Expr::Int8 && "Bulk writes are bytewise!");
+    if (ConstantExpr *CE = dyn_cast<ConstantExpr>(bytes[i])) {
+      if (!runSize)
+        runBegin = i;
+      run[runSize++] = (uint8_t) CE->getZExtValue(8);
+      if (runSize == sizeof(run)) {
+        write(offset + runBegin, run, runSize);
+        runSize = 0;
+      }
+    } else {
+      if (runSize) {
+        write(offset + runBegin, run, runSize);
+        runSize = 0;
+      }
+      write8(offset + i, bytes[i]);
+    }
+  }
+  if (runSize)
+    write(offset + runBegin, run, runSize);
+}
+
 void ObjectState::print() {
   llvm::errs() << "-- ObjectState --\n";
   llvm::errs() << "\tMemoryObject ID: " << object->id << "\n";
@@ -12,6 +12,7 @@
 
 #include "Context.h"
 #include "klee/Expr.h"
+#include "klee/util/PagedArray.h"
 
 #include "llvm/ADT/StringExtras.h"
 
@@ -156,14 +157,16 @@ private:
 
   const MemoryObject *object;
 
-  uint8_t *concreteStore;
+  /// Concrete bytes and known symbolic bytes are kept in pages that are
+  /// shared with the copies of this object.
+  PagedArray<uint8_t> concreteStore;
   // XXX cleanup name of flushMask (its backwards or something)
   BitArray *concreteMask;
 
   // mutable because may need flushed during read of const
   mutable BitArray *flushMask;
 
-  ref<Expr> *knownSymbolics;
+  PagedArray< ref<Expr> > *knownSymbolics;
 
   // mutable because we may need flush during read of const
   mutable UpdateList updates;
@@ -208,6 +211,12 @@ public:
   void write32(unsigned offset, uint32_t value);
   void write64(unsigned offset, uint64_t value);
 
+  /// Copy a range of concrete bytes into the object in one go.
+  void write(unsigned offset, const uint8_t *values, unsigned count);
+  /// Write a sequence of byte sized expressions starting at a constant
+  /// offset. Runs of constant bytes are copied in bulk.
+  void write(unsigned offset, const ref<Expr> *bytes, unsigned count);
+
 private:
   const UpdateList &getUpdates() const;
 
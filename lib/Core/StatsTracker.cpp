@@ -59,6 +59,7 @@
 
 #include <fstream>
 #include <unistd.h>
+#include <vector>
 
 using namespace klee;
 using namespace llvm;
@@ -402,6 +403,24 @@ void StatsTracker::markBranchVisited(ExecutionState *visitedTrue,
   }
 }
 
+namespace {
+  typedef std::vector<std::pair<Statistic*, bool> > StatsColumns;
+
+  StatsColumns &extraStatsColumns() {
+    static StatsColumns columns;
+    return columns;
+  }
+}
+
+void StatsTracker::addStatsColumn(Statistic &statistic, bool isTime) {
+  StatsColumns &columns = extraStatsColumns();
+  for (StatsColumns::const_iterator it = columns.begin(), ie = columns.end();
+       it != ie; ++it)
+    if (it->first == &statistic)
+      return;
+  columns.push_back(std::make_pair(&statistic, isTime));
+}
+
 void StatsTracker::writeStatsHeader() {
   *statsFile << "('Instructions',"
              << "'FullBranches',"
@@ -424,7 +443,12 @@ void StatsTracker::writeStatsHeader() {
 #ifdef DEBUG
 	     << "'ArrayHashTime',"
 #endif
-             << ")\n";
+             ;
+  StatsColumns const &columns = extraStatsColumns();
+  for (StatsColumns::const_iterator it = columns.begin(), ie = columns.end();
+       it != ie; ++it)
+    *statsFile << "'" << it->first->getName() << "',";
+  *statsFile << ")\n";
   statsFile->flush();
 }
 
@@ -454,7 +478,16 @@ void StatsTracker::writeStatsLine() {
 #ifdef DEBUG
              << "," << stats::arrayHashTime / 1000000.
 #endif
-             << ")\n";
+             ;
+  StatsColumns const &columns = extraStatsColumns();
+  for (StatsColumns::const_iterator it = columns.begin(), ie = columns.end();
+       it != ie; ++it) {
+    if (it->second)
+      *statsFile << "," << it->first->getValue() / 1000000.;
+    else
+      *statsFile << "," << it->first->getValue();
+  }
+  *statsFile << ")\n";
   statsFile->flush();
 }
 
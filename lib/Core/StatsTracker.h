@@ -28,6 +28,7 @@ namespace klee {
   class InterpreterHandler;
   struct KInstruction;
   struct StackFrame;
+  class Statistic;
 
   class StatsTracker {
     friend class WriteStatsTimer;
@@ -49,6 +50,11 @@ namespace klee {
   public:
     static bool useStatistics();
 
+    /// Appends a column for the statistic to run.stats. Only has an effect
+    /// on trackers created afterwards. Time statistics (in microseconds)
+    /// are written in seconds, like the core timers.
+    static void addStatsColumn(Statistic &statistic, bool isTime);
+
   private:
     void updateStateStatistics(uint64_t addend);
     void writeStatsHeader();
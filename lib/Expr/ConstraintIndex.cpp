@@ -0,0 +1,106 @@
+//===-- ConstraintIndex.cpp -----------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/util/ConstraintIndex.h"
+
+#include "klee/util/ExprUtil.h"
+
+#include <algorithm>
+
+using namespace klee;
+
+unsigned ConstraintIndex::idOf(const Array *array) {
+  std::pair<ids_ty::iterator, bool> res =
+    ids.insert(std::make_pair(array, (unsigned) parent.size()));
+  if (res.second) {
+    parent.push_back(res.first->second);
+    rank.push_back(0);
+    members.push_back(std::vector<unsigned>());
+  }
+  return res.first->second;
+}
+
+unsigned ConstraintIndex::find(unsigned id) {
+  unsigned root = id;
+  while (parent[root] != root)
+    root = parent[root];
+  while (parent[id] != root) {
+    unsigned next = parent[id];
+    parent[id] = root;
+    id = next;
+  }
+  return root;
+}
+
+unsigned ConstraintIndex::unite(unsigned a, unsigned b) {
+  a = find(a);
+  b = find(b);
+  if (a == b)
+    return a;
+  if (rank[a] < rank[b])
+    std::swap(a, b);
+  else if (rank[a] == rank[b])
+    ++rank[a];
+  parent[b] = a;
+
+  // append the smaller list to the larger one
+  if (members[a].size() < members[b].size())
+    members[a].swap(members[b]);
+  members[a].insert(members[a].end(), members[b].begin(), members[b].end());
+  std::vector<unsigned>().swap(members[b]);
+  return a;
+}
+
+void ConstraintIndex::clear() {
+  ids.clear();
+  parent.clear();
+  rank.clear();
+  members.clear();
+  indexed = 0;
+}
+
+void ConstraintIndex::update(const std::vector< ref<Expr> > &constraints) {
+  for (; indexed < constraints.size(); ++indexed) {
+    std::vector< ref<ReadExpr> > reads;
+    findReads(constraints[indexed], /* visitUpdates= */ true, reads);
+
+    bool any = false;
+    unsigned root = 0;
+    for (unsigned i = 0; i != reads.size(); ++i) {
+      const ReadExpr *re = reads[i].get();
+      // Same as the independent solver: reads of a constant array don't alias.
+      if (re->updates.root->isConstantArray() && !re->updates.head)
+        continue;
+      unsigned id = idOf(re->updates.root);
+      root = any ? unite(root, id) : find(id);
+      any = true;
+    }
+    if (any)
+      members[root].push_back(indexed);
+  }
+}
+
+void ConstraintIndex::getDependentPositions(
+    const std::vector<const Array*> &arrays, std::vector<unsigned> &result) {
+  std::vector<unsigned> roots;
+  for (std::vector<const Array*>::const_iterator it = arrays.begin(),
+         ie = arrays.end(); it != ie; ++it) {
+    ids_ty::const_iterator id = ids.find(*it);
+    if (id != ids.end())
+      roots.push_back(find(id->second));
+  }
+  std::sort(roots.begin(), roots.end());
+  roots.erase(std::unique(roots.begin(), roots.end()), roots.end());
+
+  size_t const first = result.size();
+  for (std::vector<unsigned>::const_iterator it = roots.begin(),
+         ie = roots.end(); it != ie; ++it)
+    result.insert(result.end(), members[*it].begin(), members[*it].end());
+  std::sort(result.begin() + first, result.end());
+}
@@ -93,9 +93,22 @@ bool ConstraintManager::rewriteConstraints(ExprVisitor &visitor) {
     }
   }
 
+  if (changed)
+    index.clear();
   return changed;
 }
 
+void ConstraintManager::getDependentConstraints(
+    const std::vector<const Array*> &arrays,
+    std::vector< ref<Expr> > &result) const {
+  index.update(constraints);
+  std::vector<unsigned> positions;
+  index.getDependentPositions(arrays, positions);
+  for (std::vector<unsigned>::const_iterator it = positions.begin(),
+         ie = positions.end(); it != ie; ++it)
+    result.push_back(constraints[*it]);
+}
+
 void ConstraintManager::simplifyForValidConstraint(ref<Expr> e) {
   // XXX 
 }
@@ -22,6 +22,12 @@
 #include "klee/util/ExprPPrinter.h"
 
 #include <sstream>
+#include <tr1/unordered_map>
+#include <vector>
+
+#ifdef KLEE_ENABLE_THREAD_SAFE_EXPRS
+#include <pthread.h>
+#endif
 
 using namespace klee;
 using namespace llvm;
@@ -31,11 +37,128 @@ namespace {
   ConstArrayOpt("const-array-opt",
 	 cl::init(false),
 	 cl::desc("Enable various optimizations involving all-constant arrays."));
+
+  cl::opt<bool, true>
+  HashConsExprs("hash-cons-exprs",
+         cl::location(Expr::hashConsing),
+         cl::init(false),
+         cl::desc("Share one node between all structurally equal expressions (default=off)."));
 }
 
 /***/
 
 unsigned Expr::count = 0;
+bool Expr::hashConsing = false;
+
+namespace {
+  // One stripe of the unique table. The stripes are only locked once
+  // expressions are shared between threads.
+  struct UniqueStripe {
+    typedef std::tr1::unordered_multimap<unsigned, Expr *> Nodes;
+    Nodes nodes;
+#ifdef KLEE_ENABLE_THREAD_SAFE_EXPRS
+    pthread_mutex_t mutex;
+    UniqueStripe() : nodes() { pthread_mutex_init(&mutex, 0); }
+#endif
+  };
+
+#ifdef KLEE_ENABLE_THREAD_SAFE_EXPRS
+  const unsigned UniqueStripes = 64;
+#else
+  const unsigned UniqueStripes = 1;
+#endif
+
+  // Never destroyed, expressions may outlive any static object.
+  UniqueStripe &uniqueStripe(unsigned hash) {
+    static UniqueStripe *const stripes = new UniqueStripe[UniqueStripes];
+    return stripes[hash % UniqueStripes];
+  }
+
+  class StripeLock {
+#ifdef KLEE_ENABLE_THREAD_SAFE_EXPRS
+    pthread_mutex_t *mutex;
+  public:
+    explicit StripeLock(UniqueStripe &stripe)
+      : mutex(exprsAreShared() ? &stripe.mutex : 0) {
+      if (mutex)
+        pthread_mutex_lock(mutex);
+    }
+    ~StripeLock() {
+      if (mutex)
+        pthread_mutex_unlock(mutex);
+    }
+#else
+  public:
+    explicit StripeLock(UniqueStripe &) {}
+#endif
+  };
+
+  // Takes a reference to a node of the table, unless it is already being
+  // destroyed by another thread. Comparing against such a node is not safe.
+  bool retainUnique(Expr *e) {
+#ifdef KLEE_ENABLE_THREAD_SAFE_EXPRS
+    if (exprsAreShared()) {
+      unsigned count = __sync_fetch_and_add(&e->refCount, 0);
+      while (count) {
+        unsigned const seen = __sync_val_compare_and_swap(&e->refCount, count, count + 1);
+        if (seen == count)
+          return true;
+        count = seen;
+      }
+      return false;
+    }
+#endif
+    incRefCount(e->refCount);
+    return true;
+  }
+}
+
+ref<Expr> Expr::unique(Expr *e) {
+  UniqueStripe &stripe = uniqueStripe(e->hashValue);
+  // nodes we retained but that turned out to be different; they may only be
+  // released without the lock, as releasing them might destroy them
+  std::vector<Expr *> candidates;
+  Expr *found = 0;
+  {
+    StripeLock lock(stripe);
+    std::pair<UniqueStripe::Nodes::iterator, UniqueStripe::Nodes::iterator> range =
+      stripe.nodes.equal_range(e->hashValue);
+    for (UniqueStripe::Nodes::iterator it = range.first; it != range.second; ++it) {
+      if (!retainUnique(it->second))
+        continue;
+      if (it->second->compare(*e) == 0) {
+        found = it->second;
+        break;
+      }
+      candidates.push_back(it->second);
+    }
+    if (!found) {
+      stripe.nodes.insert(std::make_pair(e->hashValue, e));
+      e->consed = true;
+    }
+  }
+  for (std::vector<Expr *>::iterator it = candidates.begin(), ie = candidates.end(); it != ie; ++it)
+    if (decRefCount((*it)->refCount) == 0)
+      delete *it;
+  if (!found)
+    return e;
+  ref<Expr> result(found);
+  decRefCount(found->refCount); // the reference retainUnique took, result holds another one
+  return result;
+}
+
+void Expr::forgetUnique(Expr *e) {
+  UniqueStripe &stripe = uniqueStripe(e->hashValue);
+  StripeLock lock(stripe);
+  std::pair<UniqueStripe::Nodes::iterator, UniqueStripe::Nodes::iterator> range =
+    stripe.nodes.equal_range(e->hashValue);
+  for (UniqueStripe::Nodes::iterator it = range.first; it != range.second; ++it) {
+    if (it->second == e) {
+      stripe.nodes.erase(it);
+      return;
+    }
+  }
+}
 
 ref<Expr> Expr::createTempRead(const Array *array, Expr::Width w) {
   UpdateList ul(array, 0);
@@ -84,6 +207,13 @@ ref<Expr> Expr::createTempRead(const Array *array, Expr::Width w) {
 }
 
 int Expr::compare(const Expr &b) const {
+#ifdef KLEE_ENABLE_THREAD_SAFE_EXPRS
+  if (exprsAreShared()) {
+    // an empty DenseSet does not allocate, so this is cheaper than a lock
+    ExprEquivSet equivs;
+    return compare(b, equivs);
+  }
+#endif
   static ExprEquivSet equivs;
   int r = compare(b, equivs);
   equivs.clear();
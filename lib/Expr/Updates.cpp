@@ -30,7 +30,7 @@ UpdateNode::UpdateNode(const UpdateNode *_next,
   */
   computeHash();
   if (next) {
-    ++next->refCount;
+    incRefCount(next->refCount);
     size = 1 + next->size;
   }
   else size = 1;
@@ -64,13 +64,13 @@ unsigned UpdateNode::computeHash() {
 UpdateList::UpdateList(const Array *_root, const UpdateNode *_head)
   : root(_root),
     head(_head) {
-  if (head) ++head->refCount;
+  if (head) incRefCount(head->refCount);
 }
 
 UpdateList::UpdateList(const UpdateList &b)
   : root(b.root),
     head(b.head) {
-  if (head) ++head->refCount;
+  if (head) incRefCount(head->refCount);
 }
 
 UpdateList::~UpdateList() {
@@ -127,7 +127,7 @@ void UpdateList::tryFreeNodes() {
   //  nullptr
   //  ^Head0
   //
-  while (head && --head->refCount==0) {
+  while (head && decRefCount(head->refCount)==0) {
     const UpdateNode *n = head->next;
     delete head;
     head = n;
@@ -135,7 +135,7 @@ void UpdateList::tryFreeNodes() {
 }
 
 UpdateList &UpdateList::operator=(const UpdateList &b) {
-  if (b.head) ++b.head->refCount;
+  if (b.head) incRefCount(b.head->refCount);
   // Drop reference to the current head and free a chain of nodes
   // if we are the only UpdateList referencing them
   tryFreeNodes();
@@ -151,9 +151,9 @@ void UpdateList::extend(const ref<Expr> &index, const ref<Expr> &value) {
     assert(root->getRange() == value->getWidth());
   }
 
-  if (head) --head->refCount;
+  if (head) decRefCount(head->refCount);
   head = new UpdateNode(head, index, value);
-  ++head->refCount;
+  incRefCount(head->refCount);
 }
 
 int UpdateList::compare(const UpdateList &b) const {
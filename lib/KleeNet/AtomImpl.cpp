@@ -2,11 +2,27 @@
 
 #include "klee/Expr.h"
 
+#include <vector>
+
 using namespace kleenet;
 
 
 
-ConcreteAtom::ConcreteAtom(Data data) : data(data) {
+ConcreteAtom::ConcreteAtom(Data data)
+  : data(data)
+  , expr(klee::ConstantExpr::alloc(data,8*sizeof(Data))) {
+}
+
+net::util::SharedPtr<net::DataAtom> ConcreteAtom::get(Data data) {
+  // The table is never cleared, so the atoms live as long as anyone holds them.
+  static std::vector<net::util::SharedPtr<net::DataAtom> > table;
+  if (table.empty()) {
+    unsigned const values = 1u << (8*sizeof(Data));
+    table.reserve(values);
+    for (unsigned v = 0; v < values; ++v)
+      table.push_back(net::util::SharedPtr<net::DataAtom>(new ConcreteAtom(v)));
+  }
+  return table[data];
 }
 
 bool ConcreteAtom::operator==(net::DataAtom const& as) const {
@@ -17,7 +33,7 @@ bool ConcreteAtom::operator<(net::DataAtom const& as) const {
 }
 
 ConcreteAtom::operator klee::ref<klee::Expr>() const {
-  return klee::ref<klee::Expr>(klee::ConstantExpr::alloc(data,8*sizeof(Data)));
+  return expr;
 }
 
 
@@ -19,8 +19,11 @@ namespace kleenet {
     private:
       typedef uint8_t Data;
       Data data;
-    public:
+      klee::ref<klee::Expr> const expr;
       explicit ConcreteAtom(Data);
+    public:
+      // There are only 256 different concrete atoms, all of them are shared.
+      static net::util::SharedPtr<net::DataAtom> get(Data);
       virtual bool operator==(net::DataAtom const&) const;
       virtual bool operator<(net::DataAtom const&) const;
       operator klee::ref<klee::Expr>() const;
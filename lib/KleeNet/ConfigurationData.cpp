@@ -9,6 +9,8 @@
 #include "klee_headers/MemoryManager.h"
 #include "klee/Internal/Support/ErrorHandling.h"
 
+#include "llvm/Support/CommandLine.h"
+
 #include <tr1/unordered_set>
 #include <tr1/unordered_map>
 #include <sstream>
@@ -18,6 +20,24 @@
 
 #define DD net::DEBUG<net::debug::slack>
 
+namespace {
+  llvm::cl::opt<bool>
+  cacheTranslations("sde-cache-translations"
+    , llvm::cl::desc("Remember how packet data and constraints were translated for a receiving state, so that retransmissions of the same expressions do not have to be translated again (default: on). Only applies to the aliasing name mangler.")
+    , llvm::cl::init(true)
+  );
+
+  // Collects the arrays ReadTransformator::visitRead would translate.
+  struct ReadRoots : klee::ExprVisitor {
+    std::vector<klee::Array const*>& reads;
+    explicit ReadRoots(std::vector<klee::Array const*>& reads) : reads(reads) {}
+    Action visitRead(klee::ReadExpr const& re) {
+      reads.push_back(re.updates.root);
+      return Action::skipChildren();
+    }
+  };
+}
+
 namespace kleenet {
 
   class SenderTxData { // linear-time construction (linear in packet length)
@@ -80,22 +100,6 @@ namespace kleenet {
         return senderConstraints;
       }
   };
-
-  template <typename BGraph, typename Key> class ExtractReadEdgesVisitor : public klee::ExprVisitor { // cheap construction (depends on Key copy-construction)
-    private:
-      BGraph& bg;
-      Key key;
-    protected:
-      Action visitRead(klee::ReadExpr const& re) {
-        bg.addUndirectedEdge(key,re.updates.root);
-        return Action::skipChildren();
-      }
-    public:
-      ExtractReadEdgesVisitor(BGraph& bg, Key key)
-        : bg(bg)
-        , key(key) {
-      }
-  };
 }
 
 using namespace kleenet;
@@ -122,10 +126,27 @@ ReadTransformator::ReadTransformator(NameMangler& mangler
                  , Seq const& seq
                  , LazySymbolTranslator::Symbols* preImageSymbols
                  , LazySymbolTranslator::Symbols* translatedSymbols
+                 , TranslationCache* cache
                  )
   : lst(mangler,preImageSymbols,translatedSymbols)
   , seq(seq)
-  , dynamicLookup(seq.size(),klee::ref<klee::Expr>()) {
+  , dynamicLookup(seq.size(),klee::ref<klee::Expr>())
+  , cache(cache) {
+}
+
+klee::ref<klee::Expr> ReadTransformator::translate(klee::ref<klee::Expr> const expr) {
+  if (!cache || llvm::isa<klee::ConstantExpr>(expr))
+    return visit(expr);
+  CachedTranslation& entry = (*cache)[expr];
+  if (entry.expr.isNull()) {
+    entry.expr = visit(expr);
+    ReadRoots(entry.reads).visit(expr);
+  } else {
+    // the symbol translator has to see the same arrays as if we visited the expression
+    for (std::vector<klee::Array const*>::const_iterator it = entry.reads.begin(), end = entry.reads.end(); it != end; ++it)
+      lst(*it);
+  }
+  return entry.expr;
 }
 
 klee::ref<klee::Expr> const ReadTransformator::operator[](unsigned const index) {
@@ -133,32 +154,23 @@ klee::ref<klee::Expr> const ReadTransformator::operator[](unsigned const index)
   unsigned const normIndex = index % dynamicLookup.size();
   klee::ref<klee::Expr>& slot = dynamicLookup[normIndex];
   if (slot.isNull())
-    slot = visit(seq[normIndex]);
+    slot = translate(seq[normIndex]);
   return slot;
 }
 klee::ref<klee::Expr> const ReadTransformator::operator()(klee::ref<klee::Expr> const expr) {
-  return visit(expr);
+  return translate(expr);
 }
 LazySymbolTranslator::TxMap const& ReadTransformator::symbolTable() const {
   return lst.symbolTable();
 }
 
 
-void ConstraintsGraph::updateGraph() {
-  typedef klee::ConstraintManager::constraints_ty Vec;
-  for (Vec::const_iterator it = cm.begin(), end = cm.end(); it != end; ++it) {
-    ExtractReadEdgesVisitor<BGraph,Constraint>(bGraph,*it).visit(*it);
-  }
-}
-
-
-
-
 PerReceiverData::PerReceiverData(SenderTxData& txData, ConfigurationData& receiverConfig, size_t const beginPrecomputeRange, size_t const endPrecomputeRange)
   : txData(txData)
   , receiverConfig(receiverConfig)
   , nmh(txData.designation,txData.distSymbolsSrc,receiverConfig.distSymbols)
-  , rt(nmh.mangler,txData.seq,&(txData.senderSymbols))
+  , rt(nmh.mangler,txData.seq,&(txData.senderSymbols),NULL
+      ,(cacheTranslations && nmh.mangler.isConsistent())?&(receiverConfig.receivedTranslations):NULL)
   , constraintsComputed(false)
   , specialTxName(txData.specialTxName)
 {
@@ -236,6 +248,7 @@ ConfigurationData::ConfigurationData(klee::ExecutionState& state, net::Node src)
   , cg(state.constraints)
   , distSymbols(src)
   , flags(StateFlags::NONE)
+  , receivedTranslations()
   , txData(0)
   , merges(0)
   {
@@ -245,6 +258,7 @@ ConfigurationData::ConfigurationData(ConfigurationData const& from, klee::Execut
   , cg(static_cast<klee::ExecutionState*>(state)->constraints) // XXX dangerous upcast because ES may not exist yet, but cg only stores the reference, so cross your fingers XXX
   , distSymbols(from.distSymbols) // !
   , flags(from.flags)
+  , receivedTranslations()
   , txData(0)
   , merges(from.merges)
   {
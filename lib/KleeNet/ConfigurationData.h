@@ -17,19 +17,27 @@
 #include "TransmissionKind.h"
 
 #include "kleenet/State.h"
-#include "net/util/BipartiteGraph.h"
 #include "net/util/Type.h"
 #include "net/Iterator.h"
 
+#include "klee/Constraints.h"
 #include "klee/util/ExprVisitor.h"
+#include "klee/util/ExprHashMap.h"
 
 namespace klee {
   class ExecutionState;
-  class ConstraintManager;
 }
 
 namespace kleenet {
 
+  // A packet expression as it was translated for a particular receiver,
+  // together with the arrays it reads from the sender's point of view.
+  struct CachedTranslation {
+    klee::ref<klee::Expr> expr;
+    std::vector<klee::Array const*> reads;
+  };
+  typedef klee::ExprHashMap<CachedTranslation> TranslationCache;
+
   class ReadTransformator : protected klee::ExprVisitor { // linear-time construction (linear in packet length)
     public:
       typedef std::vector<klee::ref<klee::Expr> > Seq;
@@ -37,17 +45,20 @@ namespace kleenet {
       LazySymbolTranslator lst;
       Seq const& seq;
       Seq dynamicLookup;
+      TranslationCache* const cache;
       ReadTransformator(ReadTransformator const&); // don't implement
       ReadTransformator& operator=(ReadTransformator const&); // don't implement
 
       typedef klee::ExprVisitor::Action Action;
       Action visitRead(klee::ReadExpr const& re);
+      klee::ref<klee::Expr> translate(klee::ref<klee::Expr> const expr);
 
     public:
       ReadTransformator(NameMangler& mangler
                        , Seq const& seq
                        , LazySymbolTranslator::Symbols* preImageSymbols = NULL
                        , LazySymbolTranslator::Symbols* translatedSymbols = NULL
+                       , TranslationCache* cache = NULL
                        );
 
       klee::ref<klee::Expr> const operator[](unsigned const index);
@@ -55,26 +66,23 @@ namespace kleenet {
       LazySymbolTranslator::TxMap const& symbolTable() const;
   };
 
-  class ConstraintsGraph { // constant-time construction (but sizeable number of mallocs)
+  class ConstraintsGraph { // constant-time construction
     public:
       typedef klee::ref<klee::Expr> Constraint;
       typedef std::vector<Constraint> ConstraintList;
     private:
-      typedef bg::Graph<bg::Props<Constraint,klee::Array const*,net::util::UncontinuousDictionary,net::util::UncontinuousDictionary> > BGraph;
-      BGraph bGraph;
       klee::ConstraintManager& cm;
-      void updateGraph();
     public:
       ConstraintsGraph(klee::ConstraintManager& cm)
-        : bGraph()
-        , cm(cm)
+        : cm(cm)
         {
       }
+      // closure over shared arrays, served from the constraint manager's index
       template <typename ArrayContainer>
-      ConstraintList eval(ArrayContainer const request) {
-        updateGraph();
-        std::vector<Constraint> needConstrs;
-        bGraph.search(request,BGraph::IGNORE,&needConstrs);
+      ConstraintList eval(ArrayContainer const& request) {
+        std::vector<klee::Array const*> const arrays(request.begin(),request.end());
+        ConstraintList needConstrs;
+        cm.getDependentConstraints(arrays,needConstrs);
         return needConstrs;
       }
   };
@@ -96,6 +104,9 @@ namespace kleenet {
       StateDistSymbols distSymbols;
       typedef std::vector<klee::ref<klee::Expr> > ConList;
       StateFlags::BitSet flags;
+      // Translations of everything this state has received so far. Forks
+      // start out empty instead of copying it.
+      TranslationCache receivedTranslations;
     private:
       SenderTxData* txData;
       size_t merges;
@@ -4,11 +4,13 @@
 #include "kleenet/Searcher.h"
 
 #include "klee/ExecutionState.h"
+#include "klee/Internal/Support/ErrorHandling.h"
 
 #include "net/StateMapper.h"
 #include "net/ClusterCounter.h"
 #include "net/PacketCache.h"
 #include "net/Searcher.h"
+#include "net/TraceRecorder.h"
 
 #include "NetExecutor.h"
 #include "TransmitHandler.h"
@@ -44,6 +46,15 @@ namespace {
   llvm::cl::opt<bool>
   UsePhonyPackets("sde-phony-packets",
       llvm::cl::desc("Enable phony packet pruning (experimental!)."));
+
+  llvm::cl::opt<bool>
+  LazyExplosions("sde-lazy-explosions",
+      llvm::cl::desc("When terminating a cluster, explode and terminate its dscenarios one at a time instead of all at once (default=on)."),
+      llvm::cl::init(true));
+
+  llvm::cl::opt<std::string>
+  RecordNetTrace("sde-record-net-trace",
+      llvm::cl::desc("Record the calls into the net library to this file, to replay them with net-bench."));
 }
 
 
@@ -53,6 +64,8 @@ KleeNet::KleeNet(Executor* executor)
   : phonyPackets(UsePhonyPackets)
   , env(NULL)
   , executor(executor) {
+  if (!RecordNetTrace.empty() && !net::TraceRecorder::start(RecordNetTrace.c_str()))
+    klee::klee_warning("cannot write net trace to %s", RecordNetTrace.c_str());
 }
 
 KleeNet::PacketCache* KleeNet::getPacketCache() const {
@@ -95,6 +108,7 @@ void KleeNet::setStateNode(klee::ExecutionState& state, net::Node const& n) {
 }
 
 KleeNet::~KleeNet() {
+  net::TraceRecorder::stop();
 }
 
 void KleeNet::registerSearcher(Searcher* s) {
@@ -103,7 +117,7 @@ void KleeNet::registerSearcher(Searcher* s) {
 
 KleeNet::RunEnv::RunEnv(KleeNet& kleenet, klee::ExecutionState* rootState)
   : kleenet(kleenet)
-  , stateMapper(net::StateMapper::create(StateMapping,UsePhonyPackets,rootState))
+  , stateMapper(net::StateMapper::create(StateMapping,UsePhonyPackets,rootState,LazyExplosions))
   , transmitHandler(new TransmitHandler()) // XXX
   , packetCache(new KleeNet::PacketCache(*stateMapper,*transmitHandler)) // XXX
   , clusterCounter(new net::ClusterCounter(rootState))
@@ -53,6 +53,9 @@ namespace kleenet {
     klee::Array const* isReflexive(klee::Array const* array) const {
       return distSymbolsSrc.locate(array, designation, &distSymbolsSrc /*!*/);
     }
+    bool isConsistent() const {
+      return true; // once an array is distributed, its designation is no longer consulted
+    }
   };
 
 }
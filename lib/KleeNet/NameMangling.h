@@ -28,6 +28,11 @@ namespace kleenet {
     virtual klee::Array const* isReflexive(klee::Array const* array) const {
       return array; // nope
     }
+    // True if an array is always mangled to the same array for a given
+    // destination, no matter which transmission it is part of.
+    virtual bool isConsistent() const {
+      return false;
+    }
   };
 
   struct NameManglerHolder {
@@ -8,12 +8,17 @@
 #include "kleenet/Searcher.h"
 #include "kleenet/CustomSearcherFactory.h"
 
+#include "net/NetStats.h"
 #include "net/PacketCache.h"
 
+#include "klee_headers/StatsTracker.h"
+#include "klee/Internal/Support/ErrorHandling.h"
+
 #include "NetUserSearcher.h"
 #include "OverrideOpt.h"
 
 #include <algorithm>
+#include <cstdlib>
 #include <iostream>
 
 #include <net/util/debug.h>
@@ -98,8 +103,10 @@ namespace kleenet {
         for (std::vector<klee::ExecutionState*>::const_iterator it(appendix.begin()), end(appendix.end()); feasible && it != end; ++it) {
           feasible = state.transferConstraints(**it);
         }
-        if (feasible && !appendix.empty())
+        if (feasible && !appendix.empty()) {
           e->netInterpreterHandler->incDScenariosExplored();
+          ++net::stats::dscenarios;
+        }
         NetExTHnd silentHandler(e);
         NetExTHnd const& useHandler = feasible?*this:silentHandler;
         useHandler(state);
@@ -144,6 +151,18 @@ Executor::Executor(llvm::LLVMContext& context,
   conditionals.push_back(std::make_pair(&removedStates,StateCondition::removed));
   conditionals.push_back(std::make_pair(&states,StateCondition::active));
   conditionals.push_back(std::make_pair(&addedStates,StateCondition::added));
+
+  klee::StatsTracker::addStatsColumn(net::stats::dscenarios, false);
+  klee::StatsTracker::addStatsColumn(net::stats::truncatedDScenarios, false);
+  klee::StatsTracker::addStatsColumn(net::stats::clusters, false);
+  klee::StatsTracker::addStatsColumn(net::stats::transmissions, false);
+  klee::StatsTracker::addStatsColumn(net::stats::pullRequests, false);
+  klee::StatsTracker::addStatsColumn(net::stats::knownRedundantMappings, false);
+  klee::StatsTracker::addStatsColumn(net::stats::mapTime, true);
+  klee::StatsTracker::addStatsColumn(net::stats::explodeTime, true);
+  klee::StatsTracker::addStatsColumn(net::stats::commitMappingsTime, true);
+  klee::StatsTracker::addStatsColumn(net::stats::transferConstraintsTime, true);
+  klee::StatsTracker::addStatsColumn(net::stats::transmitTime, true);
 }
 
 Executor::StateCondition::Enum Executor::stateCondition(klee::ExecutionState* es) const {
@@ -205,6 +224,41 @@ void Executor::run(klee::ExecutionState& initialState) {
   klee::Executor::run(initialState);
 }
 
+size_t Executor::liveStates() const {
+  // removed states are still in 'states' until the next updateStates()
+  return states.size() + addedStates.size() - removedStates.size();
+}
+
+// The forks of a state that has no node id yet (e.g. a symbolic node
+// selector) create the nodes of one network, which every shard needs.
+bool Executor::isShardable(klee::ExecutionState const& state) const {
+  return state.persistent.node != net::Node::INVALID_NODE;
+}
+
+// KLEE picks toKill random victims, but each of ours takes its whole cluster
+// along (see terminateStateEarly), which overshoots by far and leaves states
+// in the victim list that are already gone. So we count what was actually
+// removed and skip victims that an earlier cluster already took.
+void Executor::killStatesOverMemoryCap(unsigned toKill) {
+  std::vector<klee::ExecutionState*> arr(states.begin(), states.end());
+  size_t const before = liveStates();
+  unsigned clusters = 0;
+  for (size_t N = arr.size(); N && before - liveStates() < toKill; --N) {
+    size_t idx = rand() % N;
+    // Make two pulls to try and not hit a state that
+    // covered new code.
+    if (arr[idx]->coveredNew)
+      idx = rand() % N;
+    std::swap(arr[idx], arr[N - 1]);
+    if (stateCondition(arr[N - 1]) != StateCondition::active)
+      continue;
+    terminateStateEarly(*arr[N - 1], "Memory limit exceeded.");
+    ++clusters;
+  }
+  klee::klee_warning("killed %u clusters with %u states (over memory cap, wanted %u states)",
+                     clusters, static_cast<unsigned>(before - liveStates()), toKill);
+}
+
 void Executor::terminateStateEarly_klee(klee::ExecutionState& state,
                                         llvm::Twine const& message) {
   klee::Executor::terminateStateEarly(state,message);
@@ -61,6 +61,7 @@ namespace kleenet {
         bool isVec() const { return vec; }
       };
       std::vector<std::pair<SetOrVec,StateCondition::Enum> > conditionals;
+      size_t liveStates() const;
     protected:
       KleeNet kleenet;
       // this is the same handler as klee::Executor::interpreterHandler but with correct type
@@ -70,6 +71,8 @@ namespace kleenet {
       klee::SpecialFunctionHandler* newSpecialFunctionHandler();
       klee::Searcher* constructUserSearcher(klee::Executor&);
       void run(klee::ExecutionState& initialState); // intrusively overrides klee::Executor::run
+      void killStatesOverMemoryCap(unsigned toKill); // intrusively overrides klee::Executor::killStatesOverMemoryCap
+      bool isShardable(klee::ExecutionState const&) const;
     public:
       using klee::Executor::bindLocal;
       using klee::Executor::solver;
@@ -30,6 +30,7 @@
 #include "llvm/ADT/Twine.h"
 #include "llvm/Support/CommandLine.h"
 
+#include <map>
 #include <set>
 #include <vector>
 #include <utility>
@@ -313,7 +314,7 @@ namespace kleenet {
         typedef net::util::SharedPtr<net::DataAtom> DA;
         if (out1) {
           if (isa<ConstantExpr>(re)) // this distinction is made only for the PacketCache (i.e. phony-packet semantics)
-            out1->push_back(DA(new ConcreteAtom(dyn_cast<ConstantExpr>(re)->getZExtValue())));
+            out1->push_back(ConcreteAtom::get(dyn_cast<ConstantExpr>(re)->getZExtValue()));
           else
             out1->push_back(DA(new SymbolicAtom(re)));
         }
@@ -324,16 +325,27 @@ namespace kleenet {
       return len;
     }
 
+    static bool isTrue(klee::ref<klee::Expr> const& expr) {
+      klee::ConstantExpr const* const ce = dyn_cast<klee::ConstantExpr>(expr);
+      return ce && ce->isTrue();
+    }
+
     template <typename SourceDataIdentifier /*something I can pass to acquireExprRange*/>
     void reverseMemoryTransfer(klee::ExecutionState& state, ExprBuilder::RefExpr destAddr, SourceDataIdentifier sourceDataIdentifier, size_t const len, Node const srcNode) {
       typedef ExprBuilder::RefExpr Expr;
 
-      Expr requirements = ExprBuilder::makeFalse();
       ConfigurationData::configureState(state);
       klee::Array const* array = state.makeNewSymbol(state.configurationData->self().compileSpecialSymbolName(TransmissionKind::pull),len);
       Expr accumulation = ExprBuilder::buildCompleteRead(array);
 
-      klee::ConstraintManager cm;
+      // Source states are grouped by the value they offer (after translation). Each group
+      // becomes a single disjunct "value && (C_1 || ... || C_n)", where the C_i are the
+      // distinct constraint sets under which the value was found; if any of them is trivially
+      // true, so is the whole group. Many dscenarios usually agree on what they offer, so
+      // this keeps the disjunction proportional to the number of distinct values rather
+      // than to the number of source states.
+      typedef std::map<Expr,std::set<Expr> > Offers;
+      Offers offers;
       if (net::StateMapper* const sm = netEx.kleeNet.getStateMapper()) {
         sm->findTargets(state, srcNode);
         for (net::StateMapper::iterator it = sm->begin(), end = sm->end(); it != end; ++it) {
@@ -354,13 +366,25 @@ namespace kleenet {
           (*it)->incCompletedPullRequests();
           // these constraints will have to apply to the value.
           Expr constraints(ExprBuilder::conjunction(constr.begin(),constr.end()));
-          // if the solver decides to use the value from this state for the symbol, it has to obey the constraints of this state.
-          requirements = ExprBuilder::build<klee::OrExpr>(requirements,ExprBuilder::build<klee::AndExpr>(value,constraints));
-          // note that it will at least have to choose one valuation, in order to satisfy the big-or.
+          std::set<Expr>& group = offers[value];
+          if (group.size() == 1 && isTrue(*group.begin()))
+            continue; // already unconditional
+          if (isTrue(constraints))
+            group.clear();
+          group.insert(constraints);
         }
         sm->invalidate();
       }
 
+      // if the solver decides to use the value from one group for the symbol, it has to obey the constraints of one of its states.
+      // note that it will at least have to choose one valuation, in order to satisfy the big-or.
+      Expr requirements = ExprBuilder::makeFalse();
+      for (Offers::const_iterator it = offers.begin(), end = offers.end(); it != end; ++it) {
+        Expr const constraints = ExprBuilder::foldl_map(ExprBuilder::build<klee::OrExpr>,ExprBuilder::makeFalse(),ExprBuilder::ToExpr(),it->second.begin(),it->second.end());
+        requirements = ExprBuilder::build<klee::OrExpr>(requirements,ExprBuilder::build<klee::AndExpr>(it->first,constraints));
+      }
+      DD::cout << "Pulled " << offers.size() << " distinct values." << DD::endl;
+
       DD::cout << "Pulled REQUIREMENTS: " << DD::endl << "   ";
       pprint(DD(),requirements,"   ");
 
@@ -495,7 +519,7 @@ namespace kleenet {
     net::ExData value;
     size_t const len = args[2]->getZExtValue();
     assert(len && "asked to kleenet_memset 0 bytes.");
-    value.push_back(net::util::SharedPtr<net::DataAtom>(new ConcreteAtom(args[1]->getZExtValue())));
+    value.push_back(ConcreteAtom::get(args[1]->getZExtValue()));
 
     main->memoryTransferWrapper(ha.state, ha.arguments[0], len, value, args[3]->getZExtValue());
   }
@@ -11,6 +11,9 @@
 #include "klee_headers/MemoryManager.h"
 #include "klee_headers/TimingSolver.h"
 #include "klee/Internal/Support/ErrorHandling.h"
+#include "klee/TimerStatIncrementer.h"
+
+#include "net/NetStats.h"
 
 #include "llvm/Support/CommandLine.h"
 
@@ -28,6 +31,12 @@ namespace {
     , llvm::cl::desc("If you activate this option you will see the actual packet data that travelled through the virtual wire as individual symbols. Default: off.")
   );
 
+  llvm::cl::opt<bool>
+  batchConstraintTransfer("sde-batch-constraint-transfer"
+    , llvm::cl::desc("Decide the feasibility of all constraints that are merged into a state with one solver query instead of one query per constraint. Default: on.")
+    , llvm::cl::init(true)
+  );
+
 }
 
 using namespace kleenet;
@@ -52,6 +61,7 @@ State* State::forceFork() {
 }
 
 bool State::transferConstraints(State& onto) {
+  klee::TimerStatIncrementer timer(net::stats::transferConstraintsTime);
   bool isFeasible = true; // we are gullible sons of *******
   if (configurationData && onto.configurationData) {
     std::vector<klee::ref<klee::Expr> > constraints =
@@ -59,29 +69,59 @@ bool State::transferConstraints(State& onto) {
 
     DD::cout << "ConstraintSet:" << DD::endl << "  "; pprint(DD(), onto.executionState()->constraints, "  ");
 
-    for (std::vector<klee::ref<klee::Expr> >::const_iterator it = constraints.begin(), end = constraints.end(); isFeasible && it != end; ++it) {
-      DD::cout << "________________________________________________________________________________" << DD::endl;
-      DD::cout << " . I got a constraint to transfer: " << DD::endl;
-      DD::cout << " .   # "; pprint(DD(), *it, " .   # ");
-      DD::cout << " . simplified to: " << DD::endl;
-      klee::ref<klee::Expr> simplified = onto.executionState()->constraints.simplifyExpr(*it);
-      DD::cout << " .   # "; pprint(DD(), simplified, " .   # ");
-      klee::Solver::Validity validity;
-      bool success = executor->getTimingSolver()->evaluate(*(onto.executionState()),simplified,validity);
-      assert(success && "Unhandled solver error");
-      switch (validity) {
-        case klee::Solver::True:
-          DD::cout << " . Ignoring this constraint, because it's already given by the current constraint set." << DD::endl;
-          break;
-        case klee::Solver::False:
-          DD::cout << " . This constraint is incompatible with the current constraint set. This is a false positive." << DD::endl;
-          isFeasible = false;
-          break;
-        case klee::Solver::Unknown:
-          onto.executionState()->constraints.addConstraint(simplified);
-          break;
+    if (batchConstraintTransfer) {
+      // Every constraint on its own would cost us a query against the whole
+      // constraint set of the receiver. Instead we only filter out what
+      // simplifies to a constant and ask the solver once for the conjunction.
+      std::vector<klee::ref<klee::Expr> > pending;
+      for (std::vector<klee::ref<klee::Expr> >::const_iterator it = constraints.begin(), end = constraints.end(); isFeasible && it != end; ++it) {
+        klee::ref<klee::Expr> simplified = onto.executionState()->constraints.simplifyExpr(*it);
+        if (klee::ConstantExpr* const ce = llvm::dyn_cast<klee::ConstantExpr>(simplified)) {
+          isFeasible = ce->isTrue();
+        } else {
+          pending.push_back(simplified);
+        }
+      }
+      if (isFeasible && !pending.empty()) {
+        klee::ref<klee::Expr> conjunction = pending.front();
+        for (std::vector<klee::ref<klee::Expr> >::const_iterator it = pending.begin() + 1, end = pending.end(); it != end; ++it)
+          conjunction = klee::AndExpr::create(conjunction,*it);
+        DD::cout << " . Batch of " << pending.size() << " constraints to transfer: " << DD::endl;
+        DD::cout << " .   # "; pprint(DD(), conjunction, " .   # ");
+        bool success = executor->getTimingSolver()->mayBeTrue(*(onto.executionState()),conjunction,isFeasible);
+        assert(success && "Unhandled solver error");
+        if (isFeasible) {
+          for (std::vector<klee::ref<klee::Expr> >::const_iterator it = pending.begin(), end = pending.end(); it != end; ++it)
+            onto.executionState()->constraints.addConstraint(*it);
+        } else {
+          DD::cout << " . This batch is incompatible with the current constraint set. This is a false positive." << DD::endl;
+        }
+      }
+    } else {
+      for (std::vector<klee::ref<klee::Expr> >::const_iterator it = constraints.begin(), end = constraints.end(); isFeasible && it != end; ++it) {
+        DD::cout << "________________________________________________________________________________" << DD::endl;
+        DD::cout << " . I got a constraint to transfer: " << DD::endl;
+        DD::cout << " .   # "; pprint(DD(), *it, " .   # ");
+        DD::cout << " . simplified to: " << DD::endl;
+        klee::ref<klee::Expr> simplified = onto.executionState()->constraints.simplifyExpr(*it);
+        DD::cout << " .   # "; pprint(DD(), simplified, " .   # ");
+        klee::Solver::Validity validity;
+        bool success = executor->getTimingSolver()->evaluate(*(onto.executionState()),simplified,validity);
+        assert(success && "Unhandled solver error");
+        switch (validity) {
+          case klee::Solver::True:
+            DD::cout << " . Ignoring this constraint, because it's already given by the current constraint set." << DD::endl;
+            break;
+          case klee::Solver::False:
+            DD::cout << " . This constraint is incompatible with the current constraint set. This is a false positive." << DD::endl;
+            isFeasible = false;
+            break;
+          case klee::Solver::Unknown:
+            onto.executionState()->constraints.addConstraint(simplified);
+            break;
+        }
+        DD::cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << DD::endl;
       }
-      DD::cout << "~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~" << DD::endl;
     }
 
     DD::cout << "EOF transferConstraints" << DD::endl << DD::endl;
@@ -6,9 +6,11 @@
 #include "ConstraintSet.h"
 
 #include "net/Iterator.h"
+#include "net/NetStats.h"
 #include "net/util/Containers.h"
 
 #include "klee/ExecutionState.h"
+#include "klee/TimerStatIncrementer.h"
 #include "klee_headers/Memory.h"
 #include "klee_headers/MemoryManager.h"
 
@@ -75,11 +77,16 @@ void TransmitHandler::handleTransmission(klee::ExecutionState& receiver, klee::O
       receiver.constraints.addConstraint(ExprBuilder::buildEquality(r8,receiverData[i]));
     }
   } else {
+    std::vector<klee::ref<klee::Expr> > packet;
+    packet.reserve(size);
     for (size_t i = 0; i < size; i++) {
+      packet.push_back(receiverData[i]);
       DD::cout << "| " << "Packet[" << i << "] = ";
-      DD::cout << "|    "; pprint(receiverData[i]);
-      wosDest->write(offset + i, receiverData[i]);
+      DD::cout << "|    "; pprint(packet.back());
     }
+    // concrete stretches of the packet are copied in bulk
+    if (size)
+      wosDest->write(offset, &packet[0], size);
   }
   DD::cout << "| " << "Processing OFFENDING constraints:" << DD::endl;
   for (std::vector<klee::ref<klee::Expr> >::const_iterator it = constr.begin(), end = constr.end(); it != end; ++it) {
@@ -90,6 +97,7 @@ void TransmitHandler::handleTransmission(klee::ExecutionState& receiver, klee::O
 }
 
 void TransmitHandler::handleTransmission(PacketInfo const& pi, net::BasicState* basicSender, net::BasicState* basicReceiver, std::vector<net::DataAtomHolder> const& data) const {
+  klee::TimerStatIncrementer timer(net::stats::transmitTime);
   size_t const currentTx = basicSender->getCompletedTransmissions() + 1;
   DD::cout << DD::endl
            << "┏━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━┓" << DD::endl
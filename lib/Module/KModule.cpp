@@ -569,6 +569,9 @@ KFunction::KFunction(llvm::Function *_function,
       Instruction *inst = static_cast<Instruction *>(it);
       ki->inst = inst;
       ki->dest = registerMap[inst];
+      ki->opcode = inst->getOpcode();
+      ki->width = inst->getType()->isSized() ?
+        km->targetData->getTypeSizeInBits(inst->getType()) : 0;
 
       if (isa<CallInst>(it) || isa<InvokeInst>(it)) {
         CallSite cs(inst);
@@ -1,4 +1,6 @@
 #include "net/BasicState.h"
+#include "net/NetStats.h"
+#include "net/TraceRecorder.h"
 
 #include "StateDependant.h"
 
@@ -27,6 +29,7 @@ size_t BasicState::getCompletedTransmissions() const {
 }
 void BasicState::incCompletedTransmissions() {
   completedTransmissions++;
+  ++stats::transmissions;
 }
 
 size_t BasicState::getCompletedPullRequests() const {
@@ -34,11 +37,14 @@ size_t BasicState::getCompletedPullRequests() const {
 }
 void BasicState::incCompletedPullRequests() {
   completedPullRequests++;
+  ++stats::pullRequests;
 }
 
 BasicState::BasicState(BasicState const& from)
   : dependants(tableSize(), NULL), fake(util::isOnStack(this)), completedTransmissions(from.completedTransmissions), completedPullRequests(from.completedPullRequests) {
 
+  // cloning the dependants may fork other states, which is part of this branch
+  TraceRecorder::Scope scope;
   assert((fake || !from.fake) && "Attempt to create a non-fake state from a fake state.");
   assert(from.dependants.size() == tableSize() && "Table size was changed after initialisation");
   if (!fake) {
@@ -51,10 +57,15 @@ BasicState::BasicState(BasicState const& from)
         }
       }
     }
+    if (TraceRecorder* const recorder = TraceRecorder::active())
+      recorder->created(&from, this);
   }
 }
 
 BasicState::~BasicState() {
+  if (TraceRecorder* const recorder = TraceRecorder::active())
+    if (!fake)
+      recorder->destroyed(this);
   //std::cout << "Destroying BasicState " << this << std::endl; // XXX
   for (size_t i = 0; i < tableSize(); i++) {
     StateDependantI* const dep(dependants[i]);
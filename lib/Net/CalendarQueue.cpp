@@ -0,0 +1,201 @@
+#include "net/CalendarQueue.h"
+
+#include <algorithm>
+#include <assert.h>
+
+using namespace net;
+
+namespace {
+  enum {
+    minBuckets = 2,
+    chunkSize = 256,
+    widthSamples = 25
+  };
+}
+
+CalendarQueue::CalendarQueue()
+  : buckets(minBuckets)
+  , width(1)
+  , events(0)
+  , nextSeq(0)
+  , lastBucket(0)
+  , bucketTop(1)
+  , cachedTop(NULL)
+  , freeList(NULL)
+  , chunks() {
+}
+
+CalendarQueue::~CalendarQueue() {
+  for (std::vector<Event*>::iterator it = chunks.begin(), en = chunks.end(); it != en; ++it)
+    delete[] *it;
+}
+
+bool CalendarQueue::before(Event const* a, Event const* b) {
+  if (a->time != b->time)
+    return a->time < b->time;
+  if (a->node != b->node)
+    return a->node < b->node;
+  return a->seq < b->seq;
+}
+
+size_t CalendarQueue::bucketOf(Time time) const {
+  return static_cast<size_t>(time / width) & (buckets.size() - 1);
+}
+
+void CalendarQueue::setPosition(Time time) {
+  lastBucket = bucketOf(time);
+  bucketTop = (time / width + 1) * width;
+}
+
+CalendarQueue::Event* CalendarQueue::allocate() {
+  if (!freeList) {
+    Event* const chunk = new Event[chunkSize];
+    chunks.push_back(chunk);
+    for (size_t i = 0; i < chunkSize; ++i) {
+      chunk[i].next = freeList;
+      freeList = chunk + i;
+    }
+  }
+  Event* const ev = freeList;
+  freeList = ev->next;
+  return ev;
+}
+
+void CalendarQueue::release(Event* ev) {
+  ev->state = NULL;
+  ev->nextOfState = NULL;
+  ev->prev = NULL;
+  ev->next = freeList;
+  freeList = ev;
+}
+
+// Events are mostly scheduled after everything else in their bucket, so the
+// sorted insertion walks backwards from the tail.
+void CalendarQueue::link(Event* ev) {
+  Bucket& b = buckets[bucketOf(ev->time)];
+  Event* after = b.tail;
+  while (after && before(ev, after))
+    after = after->prev;
+  ev->prev = after;
+  if (after) {
+    ev->next = after->next;
+    after->next = ev;
+  } else {
+    ev->next = b.head;
+    b.head = ev;
+  }
+  if (ev->next)
+    ev->next->prev = ev;
+  else
+    b.tail = ev;
+}
+
+void CalendarQueue::unlink(Event* ev) {
+  Bucket& b = buckets[bucketOf(ev->time)];
+  if (ev->prev)
+    ev->prev->next = ev->next;
+  else
+    b.head = ev->next;
+  if (ev->next)
+    ev->next->prev = ev->prev;
+  else
+    b.tail = ev->prev;
+}
+
+// Re-distributes all events over a new number of buckets. The new width is
+// three times the average distance among the earliest events, which is what
+// the dequeue position will have to walk through next.
+void CalendarQueue::resize(size_t newBucketCount) {
+  std::vector<Event*> all;
+  all.reserve(events);
+  for (Buckets::iterator it = buckets.begin(), en = buckets.end(); it != en; ++it)
+    for (Event* ev = it->head; ev; ev = ev->next)
+      all.push_back(ev);
+  assert(all.size() == events);
+
+  if (all.size() > 1) {
+    std::vector<Time> times;
+    times.reserve(all.size());
+    for (std::vector<Event*>::const_iterator it = all.begin(), en = all.end(); it != en; ++it)
+      times.push_back((*it)->time);
+    size_t const k = std::min<size_t>(widthSamples, times.size() - 1);
+    std::nth_element(times.begin(), times.begin() + k, times.end());
+    Time const tk = times[k];
+    Time const t0 = *std::min_element(times.begin(), times.begin() + k);
+    width = std::max<Time>(1, 3 * (tk - t0) / k);
+  }
+
+  buckets.assign(newBucketCount, Bucket());
+  // re-linking in ascending order keeps every insertion at a tail
+  std::sort(all.begin(), all.end(), &CalendarQueue::before);
+  for (std::vector<Event*>::const_iterator it = all.begin(), en = all.end(); it != en; ++it)
+    link(*it);
+  cachedTop = NULL;
+  setPosition(all.empty() ? Time(0) : all.front()->time);
+}
+
+CalendarQueue::Event* CalendarQueue::insert(Time time, Node node, BasicState* state) {
+  Event* const ev = allocate();
+  ev->seq = nextSeq++;
+  ev->time = time;
+  ev->node = node;
+  ev->state = state;
+  ev->nextOfState = NULL;
+  if (!events || time < bucketTop - width)
+    setPosition(time);
+  link(ev);
+  ++events;
+  if (cachedTop && before(ev, cachedTop))
+    cachedTop = ev;
+  if (events > 2 * buckets.size())
+    resize(2 * buckets.size());
+  return ev;
+}
+
+void CalendarQueue::erase(Event* ev) {
+  assert(events && ev->state);
+  unlink(ev);
+  --events;
+  if (ev == cachedTop)
+    cachedTop = NULL;
+  release(ev);
+  if (buckets.size() > minBuckets && events < buckets.size() / 2)
+    resize(buckets.size() / 2);
+}
+
+CalendarQueue::Event* CalendarQueue::top() {
+  if (cachedTop || !events)
+    return cachedTop;
+  size_t i = lastBucket;
+  Time top = bucketTop;
+  for (size_t n = buckets.size(); n; --n) {
+    Event* const ev = buckets[i].head;
+    if (ev && ev->time < top) {
+      lastBucket = i;
+      bucketTop = top;
+      return cachedTop = ev;
+    }
+    i = (i + 1) & (buckets.size() - 1);
+    top += width;
+  }
+  // a whole year without events: find the earliest head directly
+  Event* best = NULL;
+  for (Buckets::const_iterator it = buckets.begin(), en = buckets.end(); it != en; ++it)
+    if (it->head && (!best || before(it->head, best)))
+      best = it->head;
+  assert(best);
+  setPosition(best->time);
+  return cachedTop = best;
+}
+
+bool CalendarQueue::empty() const {
+  return !events;
+}
+
+size_t CalendarQueue::size() const {
+  return events;
+}
+
+size_t CalendarQueue::bucketCount() const {
+  return buckets.size();
+}
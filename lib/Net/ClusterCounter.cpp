@@ -1,4 +1,5 @@
 #include "net/ClusterCounter.h"
+#include "net/NetStats.h"
 
 #include "StateCluster.h"
 #include "MappingInformation.h"
@@ -8,7 +9,8 @@ namespace net {
     virtual void notify(Observable<StateCluster>* observable) {
     }
     virtual void notifyNew(Observable<StateCluster>* observable, Observable<StateCluster> const*) {
-      clusters.insert(observable->observed->cluster.id);
+      if (clusters.insert(observable->observed->cluster.id).second)
+        ++stats::clusters;
       observable->add(this);
       parent.change();
     }
@@ -4,7 +4,11 @@
 
 #include "net/PacketCache.h"
 
-#include <set>
+#include "MappingInformation.h"
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
 
 #include "net/util/debug.h"
 
@@ -15,21 +19,30 @@
 
 namespace net {
   struct CoojaInformation : SchedulingInformation<CoojaInformation> {
-    std::set<Time> scheduledTime;
+    typedef CalendarQueue::Event Event;
+    // The events of this state in the calendar queue, earliest first,
+    // chained through Event::nextOfState.
+    Event* scheduled;
     // danglingTimes are only used for copy construction of states
     // (to duplicate the scheduleTimes of the original state).
     // That is, these are times the state thinks it is scheduled,
     // but that it has not yet been to in our data structures.
-    std::set<Time> danglingTimes;
-    static std::set<Time> setunion(std::set<Time> a, std::set<Time> const& b) {
-      a.insert(b.begin(),b.end());
-      return a;
+    // Kept sorted and free of duplicates.
+    std::vector<Time> danglingTimes;
+    static std::vector<Time> allTimes(Event const* ev, std::vector<Time> const& dangling) {
+      std::vector<Time> scheduled;
+      for (; ev; ev = ev->nextOfState)
+        scheduled.push_back(ev->time);
+      std::vector<Time> result;
+      result.reserve(scheduled.size() + dangling.size());
+      std::set_union(scheduled.begin(), scheduled.end(), dangling.begin(), dangling.end(), std::back_inserter(result));
+      return result;
     }
     bool isDangling;
     Time scheduledBootTime;
     CoojaInformation()
       : SchedulingInformation<CoojaInformation>()
-      , scheduledTime()
+      , scheduled(NULL)
       , danglingTimes()
       , isDangling(true)
       , scheduledBootTime(0)
@@ -37,15 +50,15 @@ namespace net {
     }
     CoojaInformation(CoojaInformation const& from)
       : SchedulingInformation<CoojaInformation>(from)
-      , scheduledTime()
-      , danglingTimes(setunion(from.scheduledTime,from.danglingTimes))
+      , scheduled(NULL)
+      , danglingTimes(allTimes(from.scheduled,from.danglingTimes))
       , isDangling(true)
       , scheduledBootTime(from.scheduledBootTime)
       {
         assert(!danglingTimes.empty() && "Cannot copy-construct a state without events.");
     }
     bool isScheduled() {
-      return !scheduledTime.empty();
+      return scheduled;
     }
   };
   struct CoojaInformationHandler : SchedulingInformationHandler<CoojaInformation> {
@@ -79,24 +92,19 @@ bool CoojaSearcher::empty() const {
   return calQueue.empty();
 }
 
+// Removes the earliest event of the state.
 bool CoojaSearcher::removeState(BasicState* state) {
   CoojaInformation* schInfo = cih.stateInfo(state);
-  bool const result = schInfo->isScheduled();
-  if (result) {
-    bool needCommit = false;
-    CalQueue::iterator it = calQueue.find(*(schInfo->scheduledTime.begin()));
-    if (it != calQueue.end()) {
-      it->second.removeState(state);
-      if (it->second.empty()) {
-        needCommit = (it == calQueue.begin()) && packetCache;
-        calQueue.erase(it);
-      }
-    }
-    schInfo->scheduledTime.erase(schInfo->scheduledTime.begin());
-    if (needCommit)
-      packetCache->commitMappings();
-  }
-  return result;
+  CalendarQueue::Event* const ev = schInfo->scheduled;
+  if (!ev)
+    return false;
+  Time const time = ev->time;
+  schInfo->scheduled = ev->nextOfState;
+  calQueue.erase(ev);
+  // Once the earliest point in time has no more events, its packets can go.
+  if (packetCache && (calQueue.empty() || calQueue.top()->time > time))
+    packetCache->commitMappings();
+  return true;
 }
 
 void CoojaSearcher::operator+=(BasicState* state) {
@@ -111,9 +119,9 @@ void CoojaSearcher::operator+=(BasicState* state) {
     scheduleStateAt(state, schInfo->virtualTime, EK_Normal);
   } else {
     DD::cout << DD::endl << "New State: " << schInfo->danglingTimes.size() << " DANGLING EVENTS" << DD::endl;
-    std::set<Time> d;
+    std::vector<Time> d;
     d.swap(schInfo->danglingTimes);
-    for (std::set<Time>::const_iterator tm = d.begin(), tmEnd = d.end(); tm != tmEnd; ++tm) {
+    for (std::vector<Time>::const_iterator tm = d.begin(), tmEnd = d.end(); tm != tmEnd; ++tm) {
       scheduleStateAt(state, *tm, EK_Normal);
     }
   }
@@ -133,7 +141,9 @@ void CoojaSearcher::scheduleStateAt(BasicState* state, Time time, EventKind ekin
     while (removeState(state)){}
   }
   if (schedInfo->isDangling) {
-    schedInfo->danglingTimes.insert(time);
+    std::vector<Time>::iterator const pos = std::lower_bound(schedInfo->danglingTimes.begin(), schedInfo->danglingTimes.end(), time);
+    if (pos == schedInfo->danglingTimes.end() || *pos != time)
+      schedInfo->danglingTimes.insert(pos, time);
   } else {
     if (schedInfo->isScheduled()) {
       // FIXME FIXME FIXME: Generate Error/Testcase if we schedule an event in the past (unless we havn't been booted yet)
@@ -142,44 +152,53 @@ void CoojaSearcher::scheduleStateAt(BasicState* state, Time time, EventKind ekin
         DD::cout << "  ignoring schedule request at " << time << "! Reason: boot-time " << schedInfo->scheduledBootTime << ", virtual-time " << schedInfo->virtualTime << DD::endl;
         return;
       }
-      while (schedInfo->isScheduled() && time <= *(schedInfo->scheduledTime.begin())) {
+      while (schedInfo->isScheduled() && time <= schedInfo->scheduled->time) {
         DD::cout << "  rescheduling!" << DD::endl;
         // remove the state from the time event in the future
         removeState(state);
       }
     }
+    // find the place of the new event among the state's events
+    CalendarQueue::Event** pos = &schedInfo->scheduled;
+    while (*pos && (*pos)->time < time)
+      pos = &(*pos)->nextOfState;
+    if (*pos && (*pos)->time == time) {
+      DD::cout << "State " << state << " is already scheduled at time " << time << DD::endl;
+      return;
+    }
     DD::cout << "Honouring schedule request for state " << state << " at time " << time << " (i.e. was not dropped)." << DD::endl;
     assert(time >= lowerBound());
-    // set scheduled time
-    schedInfo->scheduledTime.insert(time);
-    // push the state into the fifo queue of the specified time event
-    calQueue[time].pushBack(state);
+    // push the state into the calendar queue; within one point in time,
+    // nodes are served in ascending order and each node's states in fifo order
+    MappingInformation* const mi = MappingInformation::retrieveDependant(state);
+    CalendarQueue::Event* const ev = calQueue.insert(time, mi?(mi->getNode()):(Node::INVALID_NODE), state);
+    ev->nextOfState = *pos;
+    *pos = ev;
     DD::cout << "Queue Size after scheduling " << calQueue.size() << DD::endl;
   }
 }
 
 BasicState* CoojaSearcher::selectState() {
-  if (calQueue.empty()) {
+  CalendarQueue::Event* const head = calQueue.top();
+  if (!head) {
     return NULL;
   }
-  CalQueue::iterator head = calQueue.begin();
-  BasicState* const headState = head->second.peakState();
-  assert(cih.stateInfo(headState)->virtualTime <= head->first);
-  if (cih.stateInfo(headState)->virtualTime != head->first) {
-    DD::cout << "[" << cih.stateInfo(headState) << "] virtualTime := " << head->first << " was " << cih.stateInfo(headState)->virtualTime << DD::endl;
+  BasicState* const headState = head->state;
+  assert(cih.stateInfo(headState)->virtualTime <= head->time);
+  if (cih.stateInfo(headState)->virtualTime != head->time) {
+    DD::cout << "[" << cih.stateInfo(headState) << "] virtualTime := " << head->time << " was " << cih.stateInfo(headState)->virtualTime << DD::endl;
   }
-  cih.stateInfo(headState)->virtualTime = head->first;
-  updateLowerBound(head->first);
+  cih.stateInfo(headState)->virtualTime = head->time;
+  updateLowerBound(head->time);
   {
     static BasicState* last = NULL;
     if (last != headState) {
-      DD::cout << DD::endl << "Selecting State " << headState << " at time " << head->first << " (vt advanced to " << getStateTime(headState) << ")" << DD::endl;
+      DD::cout << DD::endl << "Selecting State " << headState << " at time " << head->time << " (vt advanced to " << getStateTime(headState) << ")" << DD::endl;
       last = headState;
     }
   }
   return headState;
 }
-
 void CoojaSearcher::yieldState(BasicState* bs) {
   assert(!calQueue.empty() && "Yielding state although none is active!");
   assert(cih.stateInfo(bs)->isScheduled() && "Yielding an unscheduled state!");
@@ -16,6 +16,10 @@ template <typename Mapper,typename Info,typename T> DStateInformation<Mapper,Inf
 template <typename Mapper,typename Info,typename T> DStateInformation<Mapper,Info,T>::DState::DState(NodeCount nc, bool& allowResize, StateMapper& mapper)
   : util::LockableNodeTable<T>(nc,allowResize), branchTo(this), cluster(new StateCluster()) {
 }
+// The branched dstate starts out empty and is filled by the states that are
+// forked into it (see CoBInformation's copy-ctor and the CoW mappers'
+// _handleRivalledNeighbour). As every node gets a fork anyway, sharing the
+// node table with 'from' would save nothing; the forks dominate the cost.
 template <typename Mapper,typename Info,typename T> DStateInformation<Mapper,Info,T>::DState::DState(DState const& from)
   : util::LockableNodeTable<T>(from.size(),from.allowResize), branchTo(this), cluster(new StateCluster(*from.cluster)) {
 }
@@ -5,9 +5,6 @@
 #include "net/PacketCache.h"
 
 #include <vector>
-#include <functional>
-#include <algorithm>
-#include <iterator>
 
 #include "net/util/debug.h"
 
@@ -15,87 +12,101 @@
 
 namespace net {
   struct LockStepInformation : SchedulingInformation<LockStepInformation> {
-    std::vector<BasicState*>::size_type slot;
-    bool blocked;
-    bool skipOnce;
-    LockStepInformation() : slot(-1), blocked(false), skipOnce(false) {}
+    typedef std::vector<BasicState*>::size_type Slot;
+    static Slot const noSlot = static_cast<Slot>(-1);
+    Slot slot;
+    // The state sits in the blocked array iff this equals the handler's
+    // current epoch; unblocking everybody just starts a new epoch.
+    unsigned blockedEpoch;
+    LockStepInformation() : slot(noSlot), blockedEpoch(0) {}
   };
   struct LockStepInformationHandler : SchedulingInformationHandler<LockStepInformation> {
     typedef std::vector<BasicState*> States;
-    States states;
-    States::iterator next;
-    States::iterator end;
-    States::size_type nullSlots;
-    States::size_type blockedStates;
+    typedef LockStepInformation::Slot Slot;
+    // Both arrays are dense; removal swaps the last entry into the hole.
+    // active[0,cursor) already ran in the current step, active[cursor,end)
+    // is the rest of the step's batch.
+    States active;
+    States blocked;
+    Slot cursor;
+    unsigned epoch;
     Time globalTime;
     Time stepIncrement;
     LockStepInformationHandler(Time stepIncrement)
       : SchedulingInformationHandler<LockStepInformation>()
-      , states()
-      , next(states.end())
-      , end(states.end())
-      , nullSlots(0)
-      , blockedStates(0)
+      , active()
+      , blocked()
+      , cursor(0)
+      , epoch(1)
       , globalTime(0)
       , stepIncrement(stepIncrement) {
     }
     States::size_type getGovernedStates() const {
-      assert(states.size() >= nullSlots);
-      return states.size()-nullSlots;
+      return active.size() + blocked.size();
     }
-    template <typename T>
-    inline static T testAndSet(T& var, T const value) {
-      T const prev = var;
-      var = value;
-      return prev;
+    bool isBlocked(LockStepInformation const* lsi) const {
+      return lsi->blockedEpoch == epoch;
     }
-    void fastForwardJunk() {
-      while (next != end && (!*next || testAndSet(stateInfo(*next)->skipOnce,false)))
-        ++next; // fast forward junk-entries
+    void place(States& states, Slot slot, BasicState* state) {
+      states[slot] = state;
+      stateInfo(state)->slot = slot;
     }
-    void block(LockStepInformation* const lsi) {
-      if (lsi && !lsi->blocked) {
-        blockedStates++;
-        lsi->blocked = true;
-      }
+    void insertPending(BasicState* state) {
+      stateInfo(state)->blockedEpoch = 0;
+      active.push_back(NULL);
+      place(active, active.size()-1, state);
     }
-    void unblock(LockStepInformation* const lsi) {
-      if (lsi && lsi->blocked) {
-        blockedStates--;
-        lsi->blocked = false;
-      }
+    void insertDone(BasicState* state) {
+      stateInfo(state)->blockedEpoch = 0;
+      active.push_back(NULL);
+      if (cursor != active.size()-1)
+        place(active, active.size()-1, active[cursor]);
+      place(active, cursor++, state);
     }
-    void unblockAll() {
-      if (blockedStates)
-        for (States::iterator it = states.begin(), en = states.end(); it != en; ++it) {
-          if (*it)
-            stateInfo(*it)->blocked = false;
-        }
-      blockedStates = 0;
+    void insertBlocked(BasicState* state) {
+      stateInfo(state)->blockedEpoch = epoch;
+      blocked.push_back(NULL);
+      place(blocked, blocked.size()-1, state);
     }
-    bool consolidate() {
-      fastForwardJunk();
-      bool const result = next == end;
-      if (result) {
-        if (getGovernedStates() < states.capacity()/4) {
-          std::vector<BasicState*> replace(states.size()-nullSlots,NULL);
-          std::vector<BasicState*>::size_type index = 0;
-          for (std::vector<BasicState*>::const_iterator it = states.begin(), en = states.end(); it != en; ++it)
-            if (*it)
-              replace[(stateInfo(*it)->slot = index++)] = *it;
-          assert(replace.size() == index);
-          // Using swap is imperative to force vector to actually SHRINK!
-          // So we do this whole mumbo jumbo even if there are no holes.
-          states.swap(replace);
-          nullSlots = 0;
+    void erase(BasicState* state) {
+      LockStepInformation* const lsi = stateInfo(state);
+      Slot slot = lsi->slot;
+      if (isBlocked(lsi)) {
+        assert(slot < blocked.size() && blocked[slot] == state);
+        if (slot != blocked.size()-1)
+          place(blocked, slot, blocked.back());
+        blocked.pop_back();
+      } else {
+        assert(slot < active.size() && active[slot] == state);
+        if (slot < cursor) {
+          // keep the partition intact: the last done state fills the hole
+          // and the last state overall fills the one it left
+          place(active, slot, active[--cursor]);
+          slot = cursor;
         }
-        next = states.begin();
-        end = states.end();
-        fastForwardJunk();
-        assert(next != end);
-        globalTime += stepIncrement;
+        if (slot != active.size()-1)
+          place(active, slot, active.back());
+        active.pop_back();
       }
-      return result;
+      lsi->slot = LockStepInformation::noSlot;
+    }
+    // Hands out the next state of the current step.
+    BasicState* next() {
+      assert(cursor < active.size());
+      return active[cursor++];
+    }
+    bool stepExhausted() const {
+      return cursor == active.size();
+    }
+    // Starts the next step with all unblocked states. Only if nobody is left
+    // outside the barrier, the barrier is lifted for everybody.
+    void nextStep() {
+      if (active.empty()) {
+        active.swap(blocked);
+        ++epoch;
+      }
+      cursor = 0;
+      globalTime += stepIncrement;
     }
   };
 }
@@ -123,51 +134,45 @@ bool LockStepSearcher::supportsPhonyPackets() const {
 }
 
 void LockStepSearcher::barrier(BasicState* state) {
-  lsih.block(lsih.stateInfo(state));
+  LockStepInformation* const lsi = lsih.stateInfo(state);
+  if (lsi && lsi->slot != LockStepInformation::noSlot && !lsih.isBlocked(lsi)) {
+    lsih.erase(state);
+    lsih.insertBlocked(state);
+  }
 }
 
 bool LockStepSearcher::empty() const {
-  return lsih.getGovernedStates();
+  return !lsih.getGovernedStates();
 }
 void LockStepSearcher::operator+=(BasicState* state) {
   lsih.equipState(state);
-  typedef std::vector<BasicState*>::size_type Slot;
-  Slot& slot = lsih.stateInfo(state)->slot;
-  typedef LockStepInformationHandler::States::difference_type DiffType;
-  DiffType const current = lsih.next - lsih.states.begin();
-  // note "slot" is now still the slot of the parent state
-  lsih.stateInfo(state)->skipOnce = (slot != static_cast<Slot>(-1)) && (static_cast<DiffType>(slot) < current);
-  slot = lsih.states.size();
-  if (lsih.stateInfo(state)->blocked)
-    lsih.blockedStates++;
-  lsih.states.push_back(state); // potentially invalidates iterators!
-  lsih.next = lsih.states.begin() + current;
-  lsih.end = lsih.states.end();
+  LockStepInformation* const lsi = lsih.stateInfo(state);
+  // note "slot" is now still the slot of the parent state (if any)
+  if (lsi->slot == LockStepInformation::noSlot)
+    lsih.insertPending(state);
+  else if (lsih.isBlocked(lsi))
+    lsih.insertBlocked(state);
+  else if (lsi->slot < lsih.cursor)
+    lsih.insertDone(state); // parent already ran this step
+  else
+    lsih.insertPending(state);
 }
 void LockStepSearcher::operator-=(BasicState* state) {
   if (lsih.stateInfo(state)) {
-    assert(lsih.stateInfo(state)->slot < lsih.states.size());
-    lsih.unblock(lsih.stateInfo(state));
-    BasicState*& sl = lsih.states[lsih.stateInfo(state)->slot];
-    assert(sl);
-    assert(lsih.stateInfo(state) == lsih.stateInfo(sl));
-    lsih.releaseState(sl);
-    sl = NULL;
-    lsih.nullSlots++;
+    lsih.erase(state);
+    lsih.releaseState(state);
   }
 }
 BasicState* LockStepSearcher::selectState() {
-  if (lsih.getGovernedStates() == lsih.blockedStates) {
-    lsih.unblockAll();
+  if (lsih.stepExhausted()) {
+    assert(lsih.getGovernedStates());
+    // The whole batch of this step has run, so all packets sent during the
+    // step are mapped at once before the next step starts.
+    if (packetCache)
+      packetCache->commitMappings();
+    lsih.nextStep();
   }
-  BasicState* selection;
-  do {
-    while (lsih.consolidate()) {
-      if (packetCache)
-        packetCache->commitMappings();
-    }
-    selection = *lsih.next++;
-  } while (lsih.stateInfo(selection)->blocked);
+  BasicState* const selection = lsih.next();
   updateLowerBound((lsih.stateInfo(selection)->virtualTime) = lsih.globalTime);
   return selection;
 }
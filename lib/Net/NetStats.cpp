@@ -0,0 +1,15 @@
+#include "net/NetStats.h"
+
+using namespace net;
+
+klee::Statistic stats::dscenarios("DScenarios", "DSc");
+klee::Statistic stats::truncatedDScenarios("TruncatedDScenarios", "DScTrunc");
+klee::Statistic stats::clusters("Clusters", "Clu");
+klee::Statistic stats::transmissions("Transmissions", "Tx");
+klee::Statistic stats::pullRequests("PullRequests", "Pull");
+klee::Statistic stats::knownRedundantMappings("KnownRedundantMappings", "KRM");
+klee::Statistic stats::mapTime("MapTime", "Mtime");
+klee::Statistic stats::explodeTime("ExplodeTime", "Xtime");
+klee::Statistic stats::commitMappingsTime("CommitMappingsTime", "CMtime");
+klee::Statistic stats::transferConstraintsTime("TransferConstraintsTime", "TCtime");
+klee::Statistic stats::transmitTime("TransmitTime", "Txtime");
@@ -5,9 +5,12 @@
 #include "MappingInformation.h"
 #include "StateDependant.h"
 
+#include "net/NetStats.h"
 #include "net/Observer.h"
 #include "net/util/debug.h"
 
+#include "klee/TimerStatIncrementer.h"
+
 using namespace net;
 
 typedef DEBUG<debug::pcache> DD;
@@ -165,6 +168,7 @@ PacketCacheBase::PacketCacheBase(StateMapper& stateMapper)
 }
 
 void PacketCacheBase::commitMappings(Node dest, StateTrie const& st, Transmitter const& transmitter) {
+  klee::TimerStatIncrementer timer(stats::commitMappingsTime);
   struct Tx : StateTrie::Functor {
     private:
       StateMapper& stateMapper;
@@ -198,6 +202,7 @@ void PacketCacheBase::commitMappings(Node dest, StateTrie const& st, Transmitter
   };
   std::pair<size_t,size_t> const calls = st.call(Tx(stateMapper,dest,transmitter));
   knownRedundantMappings += calls.first - calls.second;
+  stats::knownRedundantMappings += calls.first - calls.second;
   std::vector<util::SharedPtr<util::DynamicFunctor<Node> > > temp;
   temp.swap(commitHooks);
   for (std::vector<util::SharedPtr<util::DynamicFunctor<Node> > >::iterator it = temp.begin(), end = temp.end(); it != end; ++it) {
@@ -2,11 +2,15 @@
 
 #include "net/Observer.h"
 #include "net/BasicState.h"
+#include "net/NetStats.h"
+#include "net/TraceRecorder.h"
 
 #include "StateCluster.h"
 #include "DStateStateMapper.h"
 #include "SuperStateMapper.h"
 
+#include "klee/TimerStatIncrementer.h"
+
 #include <cassert>
 #include <vector>
 #include <stdint.h>
@@ -110,6 +114,10 @@ Node StateMapper::getStateNode(BasicState const* state) {
   return mi->getNode();
 }
 void StateMapper::setStateNode(BasicState const* state, Node const& n) {
+  TraceRecorder::Scope scope;
+  if (TraceRecorder* const recorder = TraceRecorder::active())
+    if (scope.outermost())
+      recorder->node(state, n);
   MappingInformation* const mi = MappingInformation::retrieveDependant(state);
   if (mi)
     mi->setNode(n);
@@ -125,8 +133,8 @@ BasicState* StateMapper::fork(BasicState* state) {
   return ns;
 }
 
-StateMapperInitialiser::StateMapperInitialiser(bool phonyPackets)
-  : phonyPackets(phonyPackets) {
+StateMapperInitialiser::StateMapperInitialiser(bool phonyPackets, bool lazyExplosions)
+  : phonyPackets(phonyPackets), lazyExplosions(lazyExplosions) {
 }
 
 namespace { // avoid clashes
@@ -146,7 +154,8 @@ namespace { // avoid clashes
 /// Create the (derived) StateMapper (this method is a static factory method).
 StateMapper* StateMapper::create(StateMappingType mt,
                                  bool usePhonyPackets,
-                                 BasicState* rootState) {
+                                 BasicState* rootState,
+                                 bool lazyExplosions) {
   std::map<StateMappingType, SMBuilderInterface*> trans;
   SMBuilder<SM_COPY_ON_BRANCH,CoBStateMapper> smb1(trans);
   SMBuilder<SM_COPY_ON_WRITE,CoW1StateMapper> smb2(trans);
@@ -154,9 +163,12 @@ StateMapper* StateMapper::create(StateMappingType mt,
   SMBuilder<SM_SUPER_DSTATE,SuperStateMapperNoClustering> smb4(trans);
   SMBuilder<SM_SUPER_DSTATE_WITH_BF_CLUS,SuperStateMapperBfClustering> smb5(trans);
   SMBuilder<SM_SUPER_DSTATE_WITH_SMART_CLUS,SuperStateMapperSmartClustering> smb6(trans);
-  StateMapperInitialiser const initialiser(usePhonyPackets);
+  StateMapperInitialiser const initialiser(usePhonyPackets, lazyExplosions);
   assert(trans[mt] && "Invalid state mapping algorithm selected!");
-  return (*trans[mt])(initialiser,rootState);
+  StateMapper* const sm = (*trans[mt])(initialiser,rootState);
+  if (TraceRecorder* const recorder = TraceRecorder::active())
+    recorder->created(NULL, rootState);
+  return sm;
 }
 
 bool StateMapper::checkMappingAdmissible(BasicState const* es, Node n) const {
@@ -179,6 +191,7 @@ bool StateMapper::checkMappingAdmissible(BasicState const* es, Node n) const {
 }
 
 void StateMapper::map(BasicState *state, Node dest) {
+  klee::TimerStatIncrementer timer(stats::mapTime);
   if (checkMappingAdmissible(state,dest)) {
     _map(*state, dest);
   }
@@ -189,6 +202,7 @@ void StateMapper::map(BasicState &state, Node dest) {
 }
 
 void StateMapper::map(std::set<BasicState*> const& states, Node dest) {
+  klee::TimerStatIncrementer timer(stats::mapTime);
   std::set<BasicState*> validStates;
   for (std::set<BasicState*>::const_iterator i = states.begin(), e = states.end(); i != e; ++i) {
     if (checkMappingAdmissible(*i,dest)) {
@@ -229,6 +243,7 @@ void StateMapper::explode(BasicState* state,
     "Cannot explode dstate if there are still valid targets."
     " Invalidate first.");
   assert(state && "Cannot explode dstate of NULL.");
+  klee::TimerStatIncrementer timer(stats::explodeTime);
   assert(stateInfo(state) && "Exploding state without Mapping Information.");
   if (stateInfo(state)->getNode() == Node::INVALID_NODE)
     return;
@@ -366,6 +381,7 @@ void StateMapper::remove(BasicState *state) {
     assert(!MappingInformation::retrieveDependant(*si) && "StateDependant didn't clean up correctly.");
   }
   ++_truncatedDScenarios;
+  ++stats::truncatedDScenarios;
 }
 
 size_t StateMapper::findTargets(BasicState const* state, Node const dest) const {
@@ -373,6 +389,10 @@ size_t StateMapper::findTargets(BasicState const* state, Node const dest) const
 }
 
 size_t StateMapper::findTargets(BasicState const& state, Node const dest) const {
+  TraceRecorder::Scope scope;
+  if (TraceRecorder* const recorder = TraceRecorder::active())
+    if (scope.outermost())
+      recorder->find(&state, dest);
   assert((!validTargets) &&
     "Cannot find targets if there are still valid targets."
     "Invalidate first.");
@@ -418,6 +438,12 @@ void StateMapper::setNodeCount(unsigned nodeCount) {
 }
 
 bool StateMapper::terminateCluster(BasicState& state, TerminateStateHandler const& terminate) {
+  TraceRecorder::Scope scope;
+  if (TraceRecorder* const recorder = TraceRecorder::active())
+    if (scope.outermost())
+      recorder->terminate(&state);
+  if (lazyExplosions)
+    return terminateClusterLazily(state, terminate);
   static unsigned depth = 0;
   depth++;
   MappingInformation* const mi = MappingInformation::retrieveDependant(&state);
@@ -471,3 +497,79 @@ bool StateMapper::terminateCluster(BasicState& state, TerminateStateHandler cons
   depth--;
   return knownState;
 }
+
+void StateMapper::isolate(BasicState* state) {
+  Node const nd = stateInfo(state)->getNode();
+  std::vector<BasicState*> peers;
+  for (;;) {
+    // Same cleaning sequence as in explode: afterwards 'state' has no rivals.
+    for (Nodes::const_iterator i = _nodes.begin(), e = _nodes.end(); i != e; ++i)
+      map(*state, *i);
+    peers.clear();
+    bool unique = true;
+    for (Nodes::const_iterator i = _nodes.begin(), e = _nodes.end(); i != e; ++i) {
+      if (*i != nd) {
+        unique = (findTargets(*state, *i) == 1) && unique;
+        peers.insert(peers.end(), begin(), end());
+        invalidate();
+      }
+    }
+    if (unique) {
+      // 'state' sees exactly one state per node, but these have to agree.
+      for (std::vector<BasicState*>::const_iterator p = peers.begin(), pe = peers.end(); unique && p != pe; ++p) {
+        for (Nodes::const_iterator i = _nodes.begin(), e = _nodes.end(); unique && i != e; ++i) {
+          unique = findTargets(**p, *i) == 1;
+          invalidate();
+        }
+      }
+      if (unique)
+        return;
+    }
+    // Map the peers exactly like explode maps its log. Every alternative
+    // that is split off this way takes a fork of 'state' (or of a peer) with
+    // it; those forks keep sharing everything else with 'state' virtually
+    // and are left to be isolated later.
+    for (std::vector<BasicState*>::const_iterator p = peers.begin(), pe = peers.end(); p != pe; ++p) {
+      for (Nodes::const_iterator i = _nodes.begin(), e = _nodes.end(); i != e; ++i)
+        map(**p, *i);
+    }
+  }
+}
+
+bool StateMapper::terminateClusterLazily(BasicState& state, TerminateStateHandler const& terminate) {
+  typedef net::DEBUG<net::debug::term> DD;
+  MappingInformation* const mi = MappingInformation::retrieveDependant(&state);
+  bool const knownState = mi && (mi->getNode() != Node::INVALID_NODE);
+  std::vector<BasicState*> targets;
+  if (!knownState) {
+    remove(&state);
+    terminate(state,targets);
+    return false;
+  }
+  // Every state forked from here on belongs to a dscenario that has not been
+  // isolated yet, or is already gone with the dscenario it was forked into.
+  std::vector<BasicState*> pending;
+  SmStateBufferLog<std::vector<BasicState*> > logwrap(*stateLogger,pending);
+  unsigned dscenarios = 0;
+  for (BasicState* pivot = &state; pivot; ) {
+    isolate(pivot);
+    for (Nodes::const_iterator it = _nodes.begin(), ie = _nodes.end(); it != ie; ++it) {
+      if (*it != stateInfo(pivot)->getNode()) {
+        findTargets(*pivot,*it);
+        targets.insert(targets.end(),begin(),end());
+        invalidate();
+      }
+    }
+    remove(pivot);
+    terminate(*pivot,targets);
+    targets.clear();
+    ++dscenarios;
+    for (pivot = NULL; !pivot && !pending.empty(); pending.pop_back()) {
+      MappingInformation* const pmi = MappingInformation::retrieveDependant(pending.back());
+      if (pmi && pmi->getNode() != Node::INVALID_NODE)
+        pivot = pending.back();
+    }
+  }
+  DD::cout << "[StateMapper::terminateClusterLazily] terminated " << dscenarios << " dscenarios of pivot state " << (&state) << DD::endl;
+  return true;
+}
@@ -35,7 +35,7 @@ SuperInformation::SuperInformation(SuperInformation const& from)
     // just put the copy in the same dstates as 'this'
     for (util::SafeListIterator<VState*> vs(from.vstates); vs.more(); vs.next()) {
       vstateCount++;
-      if (vs.get()->dstate()->adoptVState(new VState(this))) {
+      if (vs.get()->dstate()->adoptVState(new (mapper) VState(this))) {
         assert(0 && "new VState already had a DState.");
       }
     }
@@ -57,6 +57,20 @@ VState::VState(SuperInformation *s)
 VState::~VState() {
   DD::cout << "Destroying VState " << this << DD::endl; // XXX
 }
+void* VState::operator new(size_t size, SuperStateMapper& m) {
+  assert(size == sizeof(VState));
+  return m.vstatePool.allocate();
+}
+void VState::operator delete(void* p, SuperStateMapper& m) {
+  m.vstatePool.deallocate(p);
+}
+void VState::release(VState* vs) {
+  if (vs) {
+    SuperStateMapper& m = vs->si->mapper;
+    vs->~VState();
+    m.vstatePool.deallocate(vs);
+  }
+}
 
 void VState::moveTo(SuperInformation *s) {
   if (si) {
@@ -103,6 +117,20 @@ DState::~DState() {
   mapper.activeDStates._list.drop(sli_actives);
   DD::cout << "DState dead" << DD::endl;
 }
+void* DState::operator new(size_t size, SuperStateMapper& m) {
+  assert(size == sizeof(DState));
+  return m.dstatePool.allocate();
+}
+void DState::operator delete(void* p, SuperStateMapper& m) {
+  m.dstatePool.deallocate(p);
+}
+void DState::release(DState* ds) {
+  if (ds) {
+    SuperStateMapper& m = ds->mapper;
+    ds->~DState();
+    m.dstatePool.deallocate(ds);
+  }
+}
 
 DState *DState::adoptVState(VState *vs) {
   assert(vs);
@@ -219,7 +247,7 @@ Node const& SuperInformation::setNode(Node const& n) {
   assert(!this->vstates.size() && "State has already virtual states (that could be the case if you set the node id of this state twice).");
   // Am I paranoid?
   Node const& result = MappingInformation::setNode(n);
-  mapper.getRootDState()->adoptVState(new VState(this));
+  mapper.getRootDState()->adoptVState(new (mapper) VState(this));
   return result;
 }
 
@@ -239,7 +267,7 @@ void SuperStateMapper::_remove(const std::set<BasicState*> &remstates) {
         VState * const v(vs.get());
         ds.insert(v->dstate());
         v->dstate()->abandonVState(v);
-        delete v;
+        VState::release(v);
       }
       vs.next();
       assert(!vs.more()
@@ -249,7 +277,7 @@ void SuperStateMapper::_remove(const std::set<BasicState*> &remstates) {
   }
   assert(ds.size() == 1 && "Ambiguous dstate.");
   // If we remove at least one dscenario, the rootDState is meaningless.
-  delete *(ds.begin());
+  DState::release(*(ds.begin()));
 }
 
 unsigned SuperStateMapper::countCurrentDistributedScenarios() const {
@@ -355,7 +383,7 @@ void SuperStateMapper::_map(BasicState &es, Node dest) {
         // This looks like a memory leak, but the new dstate is saved as
         // ds->heir, also we move the conflicted (rivalled) vstate to the new
         // dstate.
-        (new DState(*ds))->adoptVState(senders.get());
+        (new (*this) DState(*ds))->adoptVState(senders.get());
         // NOTE: The heir will never be reset. Always check the mark to make
         // sure the heir is up to date.
         // This technique is a bit messy, but it does the trick quite well.
@@ -417,7 +445,7 @@ void SuperStateMapper::_map(BasicState &es, Node dest) {
               // If the old dstate was recently branched we have to get a new
               // vstate for the new state and the new dstate (the old ones keep
               // their relation).
-              ods->heir->adoptVState(new VState(ni));
+              ods->heir->adoptVState(new (*this) VState(ni));
             } else {
               // The dstate wasn't branched, so just migrate there (reason:
               // super-rivals).
@@ -448,7 +476,7 @@ void SuperStateMapper::_map(BasicState &es, Node dest) {
           continue;
         for (util::SafeListIterator<VState*> vs(ds.get()->look(i)); vs.more(); vs.next()) {
           assert(ds.get() != ds.get()->heir);
-          ds.get()->heir->adoptVState(new VState(vs.get()->info()));
+          ds.get()->heir->adoptVState(new (*this) VState(vs.get()->info()));
         }
       }
     }
@@ -565,10 +593,10 @@ void SuperStateMapper::_phonyMap(std::set<BasicState*> const &states, Node dest)
     DD::cout << "total states: " << total << "; sending: " << sending << DD::endl;
     if (sending < total) {
       if (!ds->isMarked()) {
-        new DState(*ds); // is automatically stored in ds->heir
+        new (*this) DState(*ds); // is automatically stored in ds->heir
         ds->setMark(marked);
       }
-      target = new VState(target->info());
+      target = new (*this) VState(target->info());
       ds->heir->adoptVState(target);
     } else {
       DD::cout << "IGNORING PHONY PACKET!" << DD::endl;
@@ -602,7 +630,7 @@ void SuperStateMapper::_phonyMap(std::set<BasicState*> const &states, Node dest)
           util::SharedSafeList<VState*>& slist(dsit.get()->look(*n));
           cache.reserve(slist.size());
           for (util::SafeListIterator<VState*> vs(slist); vs.more(); vs.next())
-            cache.push_back(std::make_pair(dsit.get()->heir,new VState(vs.get()->info())));
+            cache.push_back(std::make_pair(dsit.get()->heir,new (*this) VState(vs.get()->info())));
           for (std::vector<std::pair<DState*,VState*> >::const_iterator avs = cache.begin(), avse = cache.end(); avs != avse; ++avs) {
             avs->first->adoptVState(avs->second);
           }
@@ -678,12 +706,12 @@ template <typename Graph> void SuperStateMapperWithClustering<Graph>::_remove(st
 
 template <typename Graph> SuperStateMapperWithClustering<Graph>::SuperStateMapperWithClustering(StateMapperInitialiser const& initialiser, BasicState* rootState)
   : SuperStateMapper(initialiser,rootState,new Graph(*this))
-  , rootDState(new DState(*this, 0)) {
+  , rootDState(new (*this) DState(*this, 0)) {
 }
 template <typename Graph> SuperStateMapperWithClustering<Graph>::~SuperStateMapperWithClustering() {
   if (rootDState) {
     assert(activeDStates.list.size() && "Root dstate exists but is not active.");
-    delete rootDState;
+    DState::release(rootDState);
     rootDState = NULL;
   }
 }
@@ -7,6 +7,7 @@
 #include "net/util/SafeList.h"
 #include "util/SharedSafeList.h"
 #include "util/NodeTable.h"
+#include "util/TypedPool.h"
 
 #include <ostream>
 
@@ -64,6 +65,14 @@ namespace net {
 
       VState(SuperInformation *s);
       ~VState();
+      // VStates live in their mapper's pool: create them with
+      // new (mapper) VState(...) and get rid of them with release.
+      static void* operator new(size_t, SuperStateMapper&);
+      static void operator delete(void*, SuperStateMapper&);
+      static void release(VState*);
+    private:
+      static void operator delete(void*); // not implemented, use release
+    public:
       void moveTo(SuperInformation *s);
       SuperInformation *info();
       DState *dstate();
@@ -104,6 +113,13 @@ namespace net {
       DState(SuperStateMapper &ssm, NodeCount expectedNodeCount);
       DState(DState &ds);
       ~DState();
+      // Same pooling as for VStates.
+      static void* operator new(size_t, SuperStateMapper&);
+      static void operator delete(void*, SuperStateMapper&);
+      static void release(DState*);
+    private:
+      static void operator delete(void*); // not implemented, use release
+    public:
       /// note: The old vstate's dstate will be forced to abandon it!
       DState *adoptVState(VState *vs);
       static DState *autoAbandonVState(VState *vs);
@@ -121,7 +137,12 @@ namespace net {
   class SuperStateMapper
     : public StateMapperIntermediateBase<SuperInformation>
     , public DState::MapperInterface {
+    friend class VState;
+    friend class DState;
     private:
+      // All vstates and dstates of this mapper are carved from these.
+      util::TypedPool<VState> vstatePool;
+      util::TypedPool<DState> dstatePool;
       // Used to partly deactivate the branching mechanism, while the mapping
       // function is active.
       unsigned ignoreProperBranches;
@@ -0,0 +1,96 @@
+#include "net/TraceRecorder.h"
+
+#include <assert.h>
+
+using namespace net;
+
+TraceRecorder*& TraceRecorder::activeRecorder() {
+  static TraceRecorder* recorder = NULL;
+  return recorder;
+}
+
+unsigned& TraceRecorder::depth() {
+  static unsigned _depth = 0;
+  return _depth;
+}
+
+TraceRecorder::TraceRecorder(FILE* file)
+  : file(file), nextId(0), ids(), atoms() {
+}
+
+TraceRecorder::~TraceRecorder() {
+  fclose(file);
+}
+
+bool TraceRecorder::start(char const* path) {
+  assert(!active() && "Only one trace can be recorded at a time.");
+  FILE* const f = fopen(path, "w");
+  if (!f)
+    return false;
+  activeRecorder() = new TraceRecorder(f);
+  return true;
+}
+
+void TraceRecorder::stop() {
+  delete activeRecorder();
+  activeRecorder() = NULL;
+}
+
+bool TraceRecorder::known(BasicState const* state) const {
+  return ids.find(state) != ids.end();
+}
+
+unsigned TraceRecorder::id(BasicState const* state) const {
+  std::map<BasicState const*,unsigned>::const_iterator const it = ids.find(state);
+  assert(it != ids.end());
+  return it->second;
+}
+
+void TraceRecorder::created(BasicState const* parent, BasicState const* state) {
+  if (!parent) {
+    // the mapper is created only once, so this is the first state we see
+    ids[state] = nextId++;
+    fprintf(file, "root %u\n", id(state));
+  } else if (known(parent)) {
+    // forks of the mapper are numbered as well, but the replay will create them by itself
+    ids[state] = nextId++;
+    // called from within the copy-ctor's scope
+    if (depth() == 1)
+      fprintf(file, "branch %u\n", id(parent));
+  }
+}
+
+void TraceRecorder::destroyed(BasicState const* state) {
+  ids.erase(state);
+}
+
+void TraceRecorder::node(BasicState const* state, Node n) {
+  if (known(state))
+    fprintf(file, "node %u %d\n", id(state), n.id);
+}
+
+void TraceRecorder::cache(BasicState const* sender, Node dest, ExData const& data) {
+  if (!known(sender))
+    return;
+  fprintf(file, "cache %u %d", id(sender), dest.id);
+  for (ExData::const_iterator it = data.begin(), end = data.end(); it != end; ++it) {
+    std::map<DataAtomHolder,unsigned>::const_iterator const atom =
+      atoms.insert(std::make_pair(*it, static_cast<unsigned>(atoms.size()))).first;
+    fprintf(file, " %u%s", atom->second, it->forceDistinction() ? "*" : "");
+  }
+  fprintf(file, "\n");
+}
+
+void TraceRecorder::commit() {
+  fprintf(file, "commit\n");
+}
+
+void TraceRecorder::find(BasicState const* state, Node dest) {
+  if (known(state))
+    fprintf(file, "find %u %d\n", id(state), dest.id);
+}
+
+void TraceRecorder::terminate(BasicState const* state) {
+  if (known(state))
+    fprintf(file, "terminate %u\n", id(state));
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace net {
+  namespace util {
+
+    /// Region allocator for objects of one type. Memory is taken from slabs
+    /// of 'SlabSize' objects by bumping a pointer; released objects go to an
+    /// intrusive free list and are reused before the slab grows. Slabs are
+    /// only returned to the heap when the pool dies, all at once.
+    /// The pool does not construct or destruct anything.
+    template <class T, size_t SlabSize = 256> class TypedPool {
+      private:
+        union Slot {
+          Slot* next;
+          // aligned like the strictest thing T could contain
+          long double alignLD;
+          void* alignP;
+          long long alignLL;
+          char storage[sizeof(T)];
+        };
+        std::vector<Slot*> slabs;
+        Slot* freeList;
+        Slot* bump;
+        Slot* bumpEnd;
+        size_t live;
+        TypedPool(TypedPool const&); // not implemented
+        TypedPool& operator=(TypedPool const&); // not implemented
+      public:
+        TypedPool() : slabs(), freeList(NULL), bump(NULL), bumpEnd(NULL), live(0) {}
+        ~TypedPool() {
+          for (typename std::vector<Slot*>::iterator it = slabs.begin(), en = slabs.end(); it != en; ++it)
+            delete[] *it;
+        }
+        void* allocate() { // O(1)
+          ++live;
+          if (freeList) {
+            Slot* const s = freeList;
+            freeList = s->next;
+            return s;
+          }
+          if (bump == bumpEnd) {
+            bump = new Slot[SlabSize];
+            bumpEnd = bump + SlabSize;
+            slabs.push_back(bump);
+          }
+          return bump++;
+        }
+        void deallocate(void* p) { // O(1)
+          if (!p)
+            return;
+          assert(live && "Releasing more objects than were allocated.");
+          --live;
+          Slot* const s = static_cast<Slot*>(p);
+          s->next = freeList;
+          freeList = s;
+        }
+        size_t size() const {
+          return live;
+        }
+    };
+  }
+}
@@ -320,14 +320,42 @@ getAllIndependentConstraintsSets(const Query &query) {
   return factors;
 }
 
+// Extracts which arrays are referenced from a particular independent set.  Examines both
+// the actual known array accesses arr[1] plus the undetermined accesses arr[x].
+static
+void calculateArrayReferences(const IndependentElementSet & ie,
+                              std::vector<const Array *> &returnVector){
+  std::set<const Array*> thisSeen;
+  for(std::map<const Array*, ::DenseSet<unsigned> >::const_iterator it = ie.elements.begin();
+      it != ie.elements.end(); it ++){
+    thisSeen.insert(it->first);
+  }
+  for(std::set<const Array *>::iterator it = ie.wholeObjects.begin();
+      it != ie.wholeObjects.end(); it ++){
+    thisSeen.insert(*it);
+  }
+  for(std::set<const Array *>::iterator it = thisSeen.begin(); it != thisSeen.end();
+      it ++){
+    returnVector.push_back(*it);
+  }
+}
+
 static 
 IndependentElementSet getIndependentConstraints(const Query& query,
                                                 std::vector< ref<Expr> > &result) {
   IndependentElementSet eltsClosure(query.expr);
   std::vector< std::pair<ref<Expr>, IndependentElementSet> > worklist;
 
-  for (ConstraintManager::const_iterator it = query.constraints.begin(), 
-         ie = query.constraints.end(); it != ie; ++it)
+  // Only constraints sharing arrays with the query, directly or through
+  // other constraints, can intersect the closure. The constraint manager
+  // keeps an index of those, which spares us looking at all others.
+  std::vector<const Array*> queryArrays;
+  calculateArrayReferences(eltsClosure, queryArrays);
+  std::vector< ref<Expr> > candidates;
+  query.constraints.getDependentConstraints(queryArrays, candidates);
+
+  for (std::vector< ref<Expr> >::const_iterator it = candidates.begin(),
+         ie = candidates.end(); it != ie; ++it)
     worklist.push_back(std::make_pair(*it, IndependentElementSet(*it)));
 
   // XXX This should be more efficient (in terms of low level copy stuff).
@@ -370,26 +398,6 @@ IndependentElementSet getIndependentConstraints(const Query& query,
 }
 
 
-// Extracts which arrays are referenced from a particular independent set.  Examines both
-// the actual known array accesses arr[1] plus the undetermined accesses arr[x].
-static
-void calculateArrayReferences(const IndependentElementSet & ie,
-                              std::vector<const Array *> &returnVector){
-  std::set<const Array*> thisSeen;
-  for(std::map<const Array*, ::DenseSet<unsigned> >::const_iterator it = ie.elements.begin();
-      it != ie.elements.end(); it ++){
-    thisSeen.insert(it->first);
-  }
-  for(std::set<const Array *>::iterator it = ie.wholeObjects.begin();
-      it != ie.wholeObjects.end(); it ++){
-    thisSeen.insert(*it);
-  }
-  for(std::set<const Array *>::iterator it = thisSeen.begin(); it != thisSeen.end();
-      it ++){
-    returnVector.push_back(*it);
-  }
-}
-
 class IndependentSolver : public SolverImpl {
 private:
   Solver *solver;
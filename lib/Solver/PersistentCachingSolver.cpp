@@ -0,0 +1,410 @@
+//===-- PersistentCachingSolver.cpp - On-disk query cache -----------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Solver.h"
+
+#include "klee/Constraints.h"
+#include "klee/Expr.h"
+#include "klee/SolverImpl.h"
+#include "klee/SolverStats.h"
+#include "klee/util/ExprPPrinter.h"
+
+#include "klee/Internal/Support/ErrorHandling.h"
+
+#include "llvm/Support/raw_ostream.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <ciso646>
+#ifdef _LIBCPP_VERSION
+#include <unordered_map>
+#define unordered_map std::unordered_map
+#else
+#include <tr1/unordered_map>
+#define unordered_map std::tr1::unordered_map
+#endif
+
+using namespace klee;
+
+namespace {
+  const char cacheMagic[8] = { 'K', 'L', 'E', 'E', 'P', 'Q', 'C', '3' };
+
+  enum RecordKind {
+    RK_Truth = 1,
+    RK_Validity = 2,
+    RK_InitialValues = 3
+  };
+
+  /// FNV-1a, so that records damaged on disk are recognised.
+  uint32_t checksum(const char *data, size_t size) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i != size; ++i)
+      hash = (hash ^ static_cast<unsigned char>(data[i])) * 16777619u;
+    return hash;
+  }
+
+  template<typename T>
+  void appendValue(std::string &buffer, const T &value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  /// Reads values from the payload of one record.
+  class RecordReader {
+    const char *pos, *end;
+
+  public:
+    RecordReader(const char *begin, const char *end) : pos(begin), end(end) {}
+
+    bool read(void *dest, size_t size) {
+      if (static_cast<size_t>(end - pos) < size)
+        return false;
+      memcpy(dest, pos, size);
+      pos += size;
+      return true;
+    }
+
+    bool atEnd() const { return pos == end; }
+  };
+
+  /// Holds an exclusive lock on a file while in scope. Every process using
+  /// the cache file takes it before touching the file, so the records of
+  /// several processes never interleave.
+  class FileLock {
+    int fd;
+
+  public:
+    explicit FileLock(int fd) : fd(fd) {
+      while (flock(fd, LOCK_EX) != 0 && errno == EINTR)
+        ;
+    }
+    ~FileLock() { flock(fd, LOCK_UN); }
+  };
+}
+
+/// Cache of core solver results which survives the process. Queries are
+/// identified by their complete KQuery rendering, so a hit is only ever
+/// served for a textually identical query. Results are appended to a flat
+/// file together with the rendering and the whole file is read back into
+/// memory when the solver is constructed. Queries which make the underlying
+/// solver fail are never recorded. Several processes may share one file:
+/// each record is appended with a single write under a file lock and
+/// carries a checksum, so a damaged record is never taken for a result.
+class PersistentCachingSolver : public SolverImpl {
+private:
+  /// The record kind followed by the KQuery rendering of the query.
+  typedef std::string CacheKey;
+
+  struct CacheEntry {
+    int8_t result;
+    std::vector< std::vector<unsigned char> > values;
+  };
+
+  typedef unordered_map<CacheKey, CacheEntry> cache_map;
+
+  Solver *solver;
+  std::string path;
+  cache_map cache;
+  /// The cache file opened for appending, -1 if results are not recorded.
+  int out;
+
+  CacheKey makeKey(RecordKind kind, const Query &query,
+                   const std::vector<const Array*> *objects = 0) const;
+  bool cacheLookup(const CacheKey &key, CacheEntry &entry) const;
+  void cacheInsert(const CacheKey &key, const CacheEntry &entry);
+  bool load();
+  void close();
+
+public:
+  PersistentCachingSolver(Solver *s, const std::string &p);
+  ~PersistentCachingSolver();
+
+  bool computeValidity(const Query&, Solver::Validity &result);
+  bool computeTruth(const Query&, bool &isValid);
+  bool computeValue(const Query& query, ref<Expr> &result) {
+    ++stats::queryPersistentCacheMisses;
+    return solver->impl->computeValue(query, result);
+  }
+  bool computeInitialValues(const Query& query,
+                            const std::vector<const Array*> &objects,
+                            std::vector< std::vector<unsigned char> > &values,
+                            bool &hasSolution);
+  SolverRunStatus getOperationStatusCode();
+  char *getConstraintLog(const Query&);
+  void setCoreSolverTimeout(double timeout);
+};
+
+PersistentCachingSolver::PersistentCachingSolver(Solver *s,
+                                                 const std::string &p)
+  : solver(s), path(p), out(-1) {
+  out = open(path.c_str(), O_RDWR | O_APPEND | O_CREAT, 0666);
+  if (out < 0) {
+    klee_warning("unable to open persistent query cache %s: %s",
+                 path.c_str(), strerror(errno));
+    return;
+  }
+  if (!load())
+    close();
+}
+
+PersistentCachingSolver::~PersistentCachingSolver() {
+  close();
+  cache.clear();
+  delete solver;
+}
+
+void PersistentCachingSolver::close() {
+  if (out >= 0)
+    ::close(out);
+  out = -1;
+}
+
+/// Renders the query as KQuery, prefixed by the record kind. For initial
+/// value queries the requested objects are part of the rendering, so the
+/// stored byte vectors always line up with the objects of a matching query.
+PersistentCachingSolver::CacheKey
+PersistentCachingSolver::makeKey(RecordKind kind, const Query &query,
+                                 const std::vector<const Array*> *objects)
+    const {
+  CacheKey key(1, static_cast<char>(kind));
+  llvm::raw_string_ostream os(key);
+  if (objects && !objects->empty())
+    ExprPPrinter::printQuery(os, query.constraints, query.expr, 0, 0,
+                             &(*objects)[0],
+                             &(*objects)[0] + objects->size());
+  else
+    ExprPPrinter::printQuery(os, query.constraints, query.expr);
+  os.flush();
+  return key;
+}
+
+bool PersistentCachingSolver::cacheLookup(const CacheKey &key,
+                                          CacheEntry &entry) const {
+  cache_map::const_iterator it = cache.find(key);
+  if (it == cache.end())
+    return false;
+  entry = it->second;
+  return true;
+}
+
+/// Record layout (native byte order): length of the payload, the payload and
+/// the checksum of length and payload. The payload is the length of the key,
+/// the key itself (kind and query text), result and, for initial value
+/// queries, the number of objects followed by each object's size and bytes.
+void PersistentCachingSolver::cacheInsert(const CacheKey &key,
+                                          const CacheEntry &entry) {
+  cache.insert(std::make_pair(key, entry));
+  if (out < 0)
+    return;
+
+  std::string record(sizeof(uint32_t), '\0');
+  appendValue(record, static_cast<uint32_t>(key.size()));
+  record += key;
+  appendValue(record, entry.result);
+  if (key[0] == RK_InitialValues) {
+    appendValue(record, static_cast<uint32_t>(entry.values.size()));
+    for (unsigned i = 0; i < entry.values.size(); ++i) {
+      appendValue(record, static_cast<uint32_t>(entry.values[i].size()));
+      record.append(entry.values[i].begin(), entry.values[i].end());
+    }
+  }
+  uint32_t const length = record.size() - sizeof(uint32_t);
+  memcpy(&record[0], &length, sizeof(length));
+  appendValue(record, checksum(record.data(), record.size()));
+
+  FileLock lock(out);
+  if (write(out, record.data(), record.size()) !=
+      static_cast<ssize_t>(record.size())) {
+    klee_warning("unable to write to persistent query cache %s, "
+                 "no longer recording queries", path.c_str());
+    close();
+  }
+}
+
+/// Decodes the payload of one record written by cacheInsert.
+static bool parseRecord(const char *begin, const char *end, std::string &key,
+                        int8_t &result,
+                        std::vector< std::vector<unsigned char> > &values) {
+  RecordReader in(begin, end);
+  uint32_t length;
+  if (!in.read(&length, sizeof(length)) || !length)
+    return false;
+  key.resize(length);
+  if (!in.read(&key[0], length) || !in.read(&result, sizeof(result)))
+    return false;
+  if (key[0] != RK_InitialValues)
+    return in.atEnd() && (key[0] == RK_Truth || key[0] == RK_Validity);
+
+  uint32_t count;
+  if (!in.read(&count, sizeof(count)))
+    return false;
+  values.resize(count);
+  for (unsigned i = 0; i < count; ++i) {
+    uint32_t size;
+    if (!in.read(&size, sizeof(size)))
+      return false;
+    values[i].resize(size);
+    if (size && !in.read(&values[i][0], size))
+      return false;
+  }
+  return in.atEnd();
+}
+
+/// Reads all good records of the cache file, holding its lock. The file is
+/// cut off at the first record that is incomplete or fails its checksum, so
+/// that new records are appended right after the last good one. Returns
+/// false if the file is not a query cache; it is left untouched then.
+bool PersistentCachingSolver::load() {
+  FileLock lock(out);
+
+  std::string contents;
+  char buffer[1 << 16];
+  for (off_t offset = 0;;) {
+    ssize_t const n = pread(out, buffer, sizeof(buffer), offset);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0) {
+      klee_warning("unable to read persistent query cache %s: %s",
+                   path.c_str(), strerror(errno));
+      return false;
+    }
+    if (n == 0)
+      break;
+    contents.append(buffer, n);
+    offset += n;
+  }
+
+  if (contents.empty())
+    return write(out, cacheMagic, sizeof(cacheMagic)) ==
+           static_cast<ssize_t>(sizeof(cacheMagic));
+  if (contents.size() < sizeof(cacheMagic) ||
+      memcmp(contents.data(), cacheMagic, sizeof(cacheMagic)) != 0) {
+    klee_warning("not using %s as persistent query cache (bad header)",
+                 path.c_str());
+    return false;
+  }
+
+  size_t good = sizeof(cacheMagic);
+  while (contents.size() - good >= 2 * sizeof(uint32_t)) {
+    const char *const record = contents.data() + good;
+    uint32_t length, sum;
+    memcpy(&length, record, sizeof(length));
+    if (contents.size() - good - 2 * sizeof(uint32_t) < length)
+      break;
+    const char *const payload = record + sizeof(length);
+    memcpy(&sum, payload + length, sizeof(sum));
+    if (sum != checksum(record, sizeof(length) + length))
+      break;
+    CacheKey key;
+    CacheEntry entry;
+    if (!parseRecord(payload, payload + length, key, entry.result,
+                     entry.values))
+      break;
+    cache[key] = entry;
+    good += 2 * sizeof(uint32_t) + length;
+  }
+
+  if (good != contents.size()) {
+    klee_warning("persistent query cache %s ends in a damaged record, "
+                 "dropping it", path.c_str());
+    if (ftruncate(out, good) != 0)
+      return false;
+  }
+  klee_message("Loaded %lu queries from persistent query cache %s",
+               static_cast<unsigned long>(cache.size()), path.c_str());
+  return true;
+}
+
+bool PersistentCachingSolver::computeValidity(const Query& query,
+                                              Solver::Validity &result) {
+  CacheKey key = makeKey(RK_Validity, query);
+  CacheEntry entry;
+  if (cacheLookup(key, entry)) {
+    ++stats::queryPersistentCacheHits;
+    result = static_cast<Solver::Validity>(entry.result);
+    return true;
+  }
+
+  ++stats::queryPersistentCacheMisses;
+  if (!solver->impl->computeValidity(query, result))
+    return false;
+
+  entry.result = static_cast<int8_t>(result);
+  cacheInsert(key, entry);
+  return true;
+}
+
+bool PersistentCachingSolver::computeTruth(const Query& query,
+                                           bool &isValid) {
+  CacheKey key = makeKey(RK_Truth, query);
+  CacheEntry entry;
+  if (cacheLookup(key, entry)) {
+    ++stats::queryPersistentCacheHits;
+    isValid = entry.result != 0;
+    return true;
+  }
+
+  ++stats::queryPersistentCacheMisses;
+  if (!solver->impl->computeTruth(query, isValid))
+    return false;
+
+  entry.result = isValid;
+  cacheInsert(key, entry);
+  return true;
+}
+
+bool PersistentCachingSolver::computeInitialValues(
+    const Query& query, const std::vector<const Array*> &objects,
+    std::vector< std::vector<unsigned char> > &values, bool &hasSolution) {
+  CacheKey key = makeKey(RK_InitialValues, query, &objects);
+  CacheEntry entry;
+  if (cacheLookup(key, entry) && entry.values.size() == objects.size()) {
+    ++stats::queryPersistentCacheHits;
+    hasSolution = entry.result != 0;
+    values = entry.values;
+    return true;
+  }
+
+  ++stats::queryPersistentCacheMisses;
+  if (!solver->impl->computeInitialValues(query, objects, values,
+                                          hasSolution))
+    return false;
+
+  entry.result = hasSolution;
+  if (hasSolution)
+    entry.values = values;
+  else
+    entry.values.assign(objects.size(), std::vector<unsigned char>());
+  cacheInsert(key, entry);
+  return true;
+}
+
+SolverImpl::SolverRunStatus
+PersistentCachingSolver::getOperationStatusCode() {
+  return solver->impl->getOperationStatusCode();
+}
+
+char *PersistentCachingSolver::getConstraintLog(const Query& query) {
+  return solver->impl->getConstraintLog(query);
+}
+
+void PersistentCachingSolver::setCoreSolverTimeout(double timeout) {
+  solver->impl->setCoreSolverTimeout(timeout);
+}
+
+///
+
+Solver *klee::createPersistentCachingSolver(Solver *s, std::string path) {
+  return new Solver(new PersistentCachingSolver(s, path));
+}
@@ -0,0 +1,50 @@
+// RUN: %llvmgcc %s -emit-llvm -O0 -c -o %t1.bc
+// RUN: rm -rf %t.klee-out
+// RUN: %klee --output-dir=%t.klee-out %t1.bc > %t1.log
+// RUN: FileCheck %s < %t1.log
+
+// A symbolic pointer that may point into any of a row of objects resolves
+// to every one of them.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define N 8
+
+int main() {
+  char *objs[N];
+  uintptr_t lo = UINTPTR_MAX, hi = 0, x;
+  char *p;
+  int i;
+
+  for (i = 0; i < N; i++) {
+    objs[i] = malloc(4);
+    if ((uintptr_t) objs[i] < lo)
+      lo = (uintptr_t) objs[i];
+    if ((uintptr_t) objs[i] > hi)
+      hi = (uintptr_t) objs[i];
+  }
+
+  klee_make_symbolic(&x, sizeof x);
+  if (x - lo >= hi + 4 - lo)
+    klee_silent_exit(0);
+  p = (char *) x;
+
+  // states pointing between the objects end with a memory error
+  *p = 1;
+
+  for (i = 0; i < N; i++)
+    if (p >= objs[i] && p < objs[i] + 4)
+      printf("object %d\n", i);
+
+  // CHECK-DAG: object 0
+  // CHECK-DAG: object 1
+  // CHECK-DAG: object 2
+  // CHECK-DAG: object 3
+  // CHECK-DAG: object 4
+  // CHECK-DAG: object 5
+  // CHECK-DAG: object 6
+  // CHECK-DAG: object 7
+  return 0;
+}
@@ -0,0 +1,81 @@
+// RUN: %llvmgcc -I%S/../../include %s -emit-llvm -g -O0 -c -o %t.bc
+// RUN: rm -rf %t.single %t.shard2 %t.shard3 %t.cache
+// RUN: %kleenet --output-dir=%t.single --sde-state-mapping=cob --sde-distributed-terminate=force-all %t.bc
+// RUN: python %S/dscenarios.py %kntest-tool %t.single > %t.single.txt
+// RUN: FileCheck %s < %t.single.txt
+// RUN: not grep error %t.single.txt
+//
+// Two and three workers share one persistent query cache.
+// RUN: %kleenet --output-dir=%t.shard2 --shard-workers=2 --persistent-query-cache=%t.cache --sde-state-mapping=cob --sde-distributed-terminate=force-all %t.bc 2> %t.shard2.log
+// RUN: python %S/dscenarios.py %kntest-tool %t.shard2 > %t.shard2.txt
+// RUN: diff %t.single.txt %t.shard2.txt
+// RUN: not grep diverged %t.shard2.log
+// RUN: head -n 1 %t.shard2/shard-0/shard-splits.txt > %t.shard2.split0
+// RUN: head -n 1 %t.shard2/shard-1/shard-splits.txt > %t.shard2.split1
+// RUN: test -s %t.shard2.split0
+// RUN: diff %t.shard2.split0 %t.shard2.split1
+//
+// RUN: %kleenet --output-dir=%t.shard3 --shard-workers=3 --persistent-query-cache=%t.cache --sde-state-mapping=cob --sde-distributed-terminate=force-all %t.bc 2> %t.shard3.log
+// RUN: python %S/dscenarios.py %kntest-tool %t.shard3 > %t.shard3.txt
+// RUN: diff %t.single.txt %t.shard3.txt
+// RUN: not grep diverged %t.shard3.log
+// RUN: head -n 1 %t.shard3/shard-0/shard-splits.txt > %t.shard3.split0
+// RUN: head -n 1 %t.shard3/shard-1/shard-splits.txt > %t.shard3.split1
+// RUN: head -n 1 %t.shard3/shard-2/shard-splits.txt > %t.shard3.split2
+// RUN: test -s %t.shard3.split0
+// RUN: diff %t.shard3.split0 %t.shard3.split1
+// RUN: diff %t.shard3.split0 %t.shard3.split2
+
+// Node 1 picks one of four packets and sends it to node 2, which branches
+// on its own input as well. Every path pins all symbolic values, so the test
+// cases of a run do not depend on the order paths were explored in.
+//
+// The fork on the node selector has to stay in every shard: it creates the
+// two nodes of the network, not two alternatives of it.
+
+// CHECK: tests: {{[1-9][0-9]*}}
+// CHECK: dscenarios: {{[2-9]|[1-9][0-9]+}}
+// CHECK: node 1: {{.*}} | node 2:
+
+#include "klee/klee.h"
+#include "kleenet/interface/kleenet.h"
+
+static unsigned char packet;
+static int full;
+
+int main() {
+  int id, i;
+  unsigned char x, z;
+
+  klee_make_symbolic(&id, sizeof(id), "id");
+  klee_assume((id == 1) | (id == 2));
+  if (id == 1)
+    kleenet_set_node_id(1);
+  else
+    kleenet_set_node_id(2);
+  kleenet_barrier();
+
+  if (id == 1) {
+    klee_make_symbolic(&x, sizeof(x), "x");
+    klee_assume(x < 4);
+    switch (x) {
+    case 0: packet = 10; break;
+    case 1: packet = 11; break;
+    case 2: packet = 12; break;
+    default: packet = 13; break;
+    }
+    kleenet_memcpy(&packet, &packet, sizeof(packet), 2);
+    kleenet_memset(&full, 1, sizeof(full), 2);
+    return 0;
+  }
+
+  klee_make_symbolic(&z, sizeof(z), "z");
+  klee_assume(z < 2);
+  if (z)
+    packet = 1;
+  for (i = 0; i < 1000 && !full; ++i)
+    ;
+  if (!full)
+    klee_report_error(__FILE__, __LINE__, "no packet", "net.err");
+  return packet;
+}
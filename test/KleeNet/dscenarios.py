@@ -0,0 +1,41 @@
+#!/usr/bin/python
+
+"""Prints the dscenarios of a kleenet output directory in a canonical form:
+the test cases are grouped by their dscenario id, and every dscenario is
+printed as the sorted list of its test cases, without the id itself. Two runs
+that explored the same dscenarios print the same, whatever order they
+explored (and numbered) them in."""
+
+from __future__ import print_function
+import glob
+import imp
+import os
+import sys
+
+
+def main(kntestTool, outDir):
+    kntest = imp.load_source('kntest', kntestTool)
+    paths = sorted(glob.glob(os.path.join(outDir, 'test*.ktest')))
+    dscenarios = {}
+    for path in paths:
+        b = kntest.KTest.fromfile(path)
+        objects = ' '.join('{0}={1}'.format(name, repr(data))
+                           for name, data in b.objects)
+        test = 'node {0}: {1}'.format(b.nodeId, objects)
+        if b.hasErr:
+            test += ' error: ' + b.errMsg
+        dscenarios.setdefault(b.dscenarioId, []).append(test)
+
+    print('tests:', len(paths))
+    print('dscenarios:', len(dscenarios))
+    for tests in sorted(' | '.join(sorted(t)) for t in dscenarios.values()):
+        print(tests)
+    return 0
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        print('usage: {0} kntest-tool output-dir'.format(sys.argv[0]),
+              file=sys.stderr)
+        sys.exit(2)
+    sys.exit(main(sys.argv[1], sys.argv[2]))
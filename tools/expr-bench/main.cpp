@@ -0,0 +1,176 @@
+//===-- main.cpp ------------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// expr-bench measures the cost of the expression core: copying references,
+// building expressions and comparing them. Run it once from a build with
+// --enable-thread-safe-exprs and once from a build without to see what the
+// thread-safe build costs a single thread. Thread-safe builds can also run the
+// workloads on several threads that share their leaves, or on one thread with
+// atomic reference counts (-shared).
+//
+//===----------------------------------------------------------------------===//
+
+#include "klee/Expr.h"
+
+#include "llvm/Support/CommandLine.h"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace klee;
+
+namespace {
+  llvm::cl::opt<unsigned>
+  Iterations("iterations",
+      llvm::cl::desc("Rounds of every workload per thread (default=200000)."),
+      llvm::cl::init(200000));
+
+  llvm::cl::opt<unsigned>
+  Threads("num-threads",
+      llvm::cl::desc("Threads running the workloads at the same time (default=1). Needs a thread-safe build."),
+      llvm::cl::init(1));
+
+  llvm::cl::opt<bool>
+  Shared("shared",
+      llvm::cl::desc("Use atomic reference counts even on a single thread. Needs a thread-safe build."));
+
+  llvm::cl::opt<unsigned>
+  Repetitions("repetitions",
+      llvm::cl::desc("Every workload is run this often, the fastest run is reported (default=5)."),
+      llvm::cl::init(5));
+}
+
+namespace {
+  // Packet sized leaves that all threads share.
+  struct Leaves {
+    Array const* const array;
+    std::vector<ref<Expr> > reads;
+    std::vector<ref<Expr> > constants;
+    explicit Leaves(unsigned size)
+      : array(new Array("bench", size)), reads(), constants() {
+      UpdateList const ul(array, 0);
+      for (unsigned i = 0; i < size; ++i) {
+        reads.push_back(ReadExpr::create(ul, ConstantExpr::alloc(i, Expr::Int32)));
+        constants.push_back(ConstantExpr::alloc(i * 7 + 1, Expr::Int8));
+      }
+    }
+    ~Leaves() {
+      reads.clear();
+      delete array;
+    }
+  };
+
+  // Copies and drops references, which is all that happens when expressions
+  // are passed around by value.
+  void copyRefs(Leaves const& leaves, unsigned iterations) {
+    std::vector<ref<Expr> > copies(leaves.reads.size());
+    for (unsigned i = 0; i < iterations; ++i) {
+      for (unsigned j = 0; j < copies.size(); ++j)
+        copies[j] = leaves.reads[(i + j) % leaves.reads.size()];
+    }
+  }
+
+  ref<Expr> build(Leaves const& leaves, unsigned i) {
+    unsigned const n = leaves.reads.size();
+    ref<Expr> const sum = AddExpr::create(leaves.reads[i % n], leaves.constants[(i + 1) % n]);
+    ref<Expr> const word = ConcatExpr::create(leaves.reads[(i + 2) % n], sum);
+    return EqExpr::create(word, ZExtExpr::create(leaves.reads[(i + 3) % n], Expr::Int16));
+  }
+
+  // Builds small packet checks out of the shared leaves.
+  void buildExprs(Leaves const& leaves, unsigned iterations) {
+    for (unsigned i = 0; i < iterations; ++i)
+      build(leaves, i);
+  }
+
+  // Compares structurally equal expressions that do not share their nodes.
+  void compareExprs(Leaves const& leaves, unsigned iterations) {
+    unsigned const distinct = 64;
+    std::vector<ref<Expr> > a, b;
+    for (unsigned i = 0; i < distinct; ++i) {
+      a.push_back(build(leaves, i));
+      b.push_back(build(leaves, i));
+    }
+    unsigned equal = 0;
+    for (unsigned i = 0; i < iterations; ++i)
+      equal += (a[i % distinct] == b[i % distinct]);
+    if (equal != iterations)
+      std::cerr << "expr-bench: warning: equal expressions compared unequal\n";
+  }
+
+  struct Workload {
+    char const* name;
+    void (*run)(Leaves const&, unsigned);
+  };
+
+  double runOnce(Workload const& workload, Leaves const& leaves) {
+    std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned t = 1; t < Threads; ++t)
+      threads.push_back(std::thread(workload.run, std::cref(leaves), unsigned(Iterations)));
+    workload.run(leaves, Iterations);
+    for (unsigned t = 0; t < threads.size(); ++t)
+      threads[t].join();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+int main(int argc, char** argv) {
+  llvm::cl::ParseCommandLineOptions(argc, argv, "expression core micro-benchmark\n");
+
+  if (!Threads || !Repetitions) {
+    std::cerr << "expr-bench: error: -num-threads and -repetitions must be positive\n";
+    return 1;
+  }
+#ifdef KLEE_ENABLE_THREAD_SAFE_EXPRS
+  bool const threadSafe = true;
+  if (Threads > 1 || Shared)
+    shareExprsBetweenThreads();
+  bool const atomic = exprsAreShared();
+#else
+  bool const threadSafe = false;
+  bool const atomic = false;
+  if (Threads > 1 || Shared) {
+    std::cerr << "expr-bench: error: -num-threads and -shared need a build with --enable-thread-safe-exprs\n";
+    return 1;
+  }
+#endif
+
+  Workload const workloads[] = {
+    {"copy-refs", copyRefs},
+    {"build", buildExprs},
+    {"compare", compareExprs},
+  };
+  Leaves const leaves(64);
+
+  std::cout << "thread-safe exprs: " << (threadSafe ? "yes" : "no")
+            << ", atomic ref counts: " << (atomic ? "yes" : "no")
+            << ", threads: " << Threads << "\n";
+  std::cout << std::setw(12) << "workload"
+            << std::setw(12) << "ms"
+            << std::setw(12) << "ns/round" << "\n";
+  for (unsigned w = 0; w < sizeof(workloads) / sizeof(workloads[0]); ++w) {
+    double best = 0;
+    for (unsigned r = 0; r < Repetitions; ++r) {
+      double const ms = runOnce(workloads[w], leaves);
+      if (!r || ms < best)
+        best = ms;
+    }
+    std::cout << std::setw(12) << workloads[w].name
+              << std::setw(12) << std::fixed << std::setprecision(2) << best
+              << std::setw(12) << std::setprecision(1) << best * 1e6 / (double(Iterations) * Threads)
+              << "\n";
+  }
+  std::cout << "live expressions: " << Expr::count << "\n";
+  return 0;
+}
@@ -11,6 +11,10 @@
 
 #include "klee/Internal/ADT/KTest.h"
 #include "klee/Config/config.h"
+#ifdef KLEENET_REPLAY
+#include "kleenet/KnTest.h"
+#include "kleenet/KnTestArchive.h"
+#endif
 
 #include <assert.h>
 #include <stdio.h>
@@ -18,6 +22,7 @@
 #include <string.h>
 #include <stdint.h>
 #include <getopt.h>
+#include <limits.h>
 
 #include <errno.h>
 #include <time.h>
@@ -255,6 +260,57 @@ static void usage(void) {
   exit(1);
 }
 
+/* Replays the test case in input, using name to refer to it. */
+static void replay_test(char *executable, char *prog0, const char *name) {
+  static unsigned replayed = 0;
+  int prg_argc;
+  char ** prg_argv;
+  unsigned i;
+
+  obj_index = 0;
+  prg_argc = input->numArgs;
+  prg_argv = input->args;
+  prg_argv[0] = prog0;
+  klee_init_env(&prg_argc, &prg_argv);
+
+  if (replayed++)
+    fprintf(stderr, "\n");
+  fprintf(stderr, "%s: TEST CASE: %s\n", progname, name);
+  fprintf(stderr, "%s: ARGS: ", progname);
+  for (i=0; i != (unsigned) prg_argc; ++i) {
+    char *s = prg_argv[i];
+    if (s[0]=='A' && s[1] && !s[2]) s[1] = '\0';
+    fprintf(stderr, "\"%s\" ", prg_argv[i]); 
+  }
+  fprintf(stderr, "\n");
+
+  /* Run the test case machinery in a subprocess, eventually this parent
+     process should be a script or something which shells out to the actual
+     execution tool. */
+  int pid = fork();
+  if (pid < 0) {
+    perror("fork");
+    _exit(66);
+  } else if (pid == 0) {
+    /* Create the input files, pipes, etc., and run the process. */
+    replay_create_files(&__exe_fs);
+    run_monitored(executable, prg_argc, prg_argv);
+    _exit(0);
+  } else {
+    /* Wait for the test case. */
+    int res, status;
+
+    do {
+      res = waitpid(pid, &status, 0);
+    } while (res < 0 && errno == EINTR);
+    
+    if (res < 0) {
+      perror("waitpid");
+      _exit(66);
+    }
+  }
+}
+
 int main(int argc, char** argv) {
   int prg_argc;
   char ** prg_argv;  
@@ -324,57 +380,37 @@ int main(int argc, char** argv) {
   int idx = 0;
   for (idx = optind + 1; idx != argc; ++idx) {
     char* input_fname = argv[idx];
-    unsigned i;
-    
+
+#ifdef KLEENET_REPLAY
+    if (knTestArchive_isArchive(input_fname)) {
+      KnTestArchive *archive = knTestArchive_open(input_fname);
+      unsigned id;
+      if (!archive) {
+        fprintf(stderr, "%s: error: input file %s not valid.\n", progname,
+                input_fname);
+        exit(1);
+      }
+      while ((input = knTestArchive_next(archive, &id))) {
+        char name[PATH_MAX];
+        char *arg0 = input->args[0];
+        snprintf(name, sizeof(name), "%s:test%06u.ktest", input_fname, id);
+        replay_test(executable, argv[optind], name);
+        input->args[0] = arg0;
+        kTest_free(input);
+      }
+      knTestArchive_close(archive);
+      continue;
+    }
+#endif
+
     input = kTest_fromFile(input_fname);
     if (!input) {
       fprintf(stderr, "%s: error: input file %s not valid.\n", progname, 
               input_fname);
       exit(1);
     }
-    
-    obj_index = 0;
-    prg_argc = input->numArgs;
-    prg_argv = input->args;
-    prg_argv[0] = argv[optind];
-    klee_init_env(&prg_argc, &prg_argv);
-
-    if (idx > 2)
-      fprintf(stderr, "\n");
-    fprintf(stderr, "%s: TEST CASE: %s\n", progname, input_fname);
-    fprintf(stderr, "%s: ARGS: ", progname);
-    for (i=0; i != (unsigned) prg_argc; ++i) {
-      char *s = prg_argv[i];
-      if (s[0]=='A' && s[1] && !s[2]) s[1] = '\0';
-      fprintf(stderr, "\"%s\" ", prg_argv[i]); 
-    }
-    fprintf(stderr, "\n");
 
-    /* Run the test case machinery in a subprocess, eventually this parent
-       process should be a script or something which shells out to the actual
-       execution tool. */
-    int pid = fork();
-    if (pid < 0) {
-      perror("fork");
-      _exit(66);
-    } else if (pid == 0) {
-      /* Create the input files, pipes, etc., and run the process. */
-      replay_create_files(&__exe_fs);
-      run_monitored(executable, prg_argc, prg_argv);
-      _exit(0);
-    } else {
-      /* Wait for the test case. */
-      int res, status;
-
-      do {
-        res = waitpid(pid, &status, 0);
-      } while (res < 0 && errno == EINTR);
-      
-      if (res < 0) {
-        perror("waitpid");
-        _exit(66);
-      }
-    }
+    replay_test(executable, argv[optind], input_fname);
   }
 
   return 0;
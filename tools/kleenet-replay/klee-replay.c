@@ -1,2 +1,3 @@
+#define KLEENET_REPLAY
 #include "../klee-replay/klee-replay.c"
 
@@ -21,6 +21,7 @@
 #include "kleenet/NetExecutorBuilder.h"
 #include "kleenet/KleeNet.h"
 #include "kleenet/KnTest.h"
+#include "kleenet/KnTestArchive.h"
 #include "net/Node.h"
 
 #include "klee/ExecutionState.h"
@@ -78,6 +79,7 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
 
+#include <algorithm>
 #include <cerrno>
 #include <fstream>
 #include <iomanip>
@@ -235,6 +237,36 @@ namespace {
            cl::desc("Use a watchdog process to enforce --max-time."),
            cl::init(0));
 
+  cl::opt<bool>
+  WriteKnTestArchive("kntest-archive",
+                cl::desc("Write all test cases into a single archive (tests.knarc) instead of "
+                         "one .ktest file each (default=off)"),
+                cl::init(false));
+
+  cl::opt<unsigned>
+  KnTestArchiveChunk("kntest-archive-chunk",
+                     cl::desc("Number of test cases buffered before they are appended to the "
+                              "archive together. Pending test cases are written out on exit, but "
+                              "are lost if kleenet crashes or is killed (default=1)"),
+                     cl::init(1));
+
+  cl::opt<unsigned>
+  ShardWorkers("shard-workers",
+               cl::desc("Split the exploration among this many local worker processes and merge "
+                        "their test cases into the output directory (requires --output-dir, default 1). "
+                        "The workers must make the same decisions until they split; the run fails if "
+                        "they diverged, e.g. because of --max-memory. Solver timeouts are not allowed. "
+                        "Forks of states without a node id are never split. A state that several "
+                        "dscenarios share (all mappers but cob) is reported by every shard that "
+                        "explores one of them. The workers may share a --persistent-query-cache."),
+               cl::init(1));
+
+  cl::opt<unsigned>
+  ShardIndex("shard-index",
+             cl::desc("Only explore this shard of --shard-workers, without spawning any workers. "
+                      "Used by the coordinator; can be given by hand to re-run a single worker."),
+             cl::init(0));
+
   cl::opt<bool>
   DumpClusterChanges("sde-dump-cluster-changes",
            cl::desc("Dump all changes of clusters on standard out, in addition to protocolling it."));
@@ -244,11 +276,23 @@ extern cl::opt<double> MaxTime;
 
 /***/
 
+// The test archive being written, so that its pending test cases are not
+// lost when kleenet exits without destroying the handler (e.g. klee_error).
+static KnTestArchive *openArchive = 0;
+
+static void flushOpenArchive() {
+  if (openArchive && !knTestArchive_flush(openArchive))
+    fprintf(stderr, "KLEE: WARNING: unable to write test archive, losing test cases\n");
+}
+
+/***/
+
 class KleeHandler : public kleenet::InterpreterHandler {
 private:
   Interpreter *m_interpreter;
   TreeStreamWriter *m_pathWriter, *m_symPathWriter;
   llvm::raw_ostream *m_infoFile;
+  KnTestArchive *m_archive;
 
   SmallString<128> m_outputDirectory;
 
@@ -332,6 +376,7 @@ KleeHandler::KleeHandler(int argc, char **argv)
     m_pathWriter(0),
     m_symPathWriter(0),
     m_infoFile(0),
+    m_archive(0),
     m_outputDirectory(),
     m_testIndex(0),
     m_pathsExplored(0),
@@ -409,9 +454,20 @@ KleeHandler::KleeHandler(int argc, char **argv)
 
   // open info
   m_infoFile = openOutputFile("info");
+
+  if (WriteKnTestArchive) {
+    file_path = getOutputFilename("tests.knarc");
+    if (!(m_archive = knTestArchive_create(file_path.c_str(), KnTestArchiveChunk)))
+      klee_error("cannot create test archive \"%s\": %s", file_path.c_str(), strerror(errno));
+    openArchive = m_archive;
+    atexit(flushOpenArchive);
+  }
 }
 
 KleeHandler::~KleeHandler() {
+  openArchive = 0;
+  if (m_archive && !knTestArchive_close(m_archive))
+    klee_warning("unable to write test archive, losing test cases");
   if (m_pathWriter) delete m_pathWriter;
   if (m_symPathWriter) delete m_symPathWriter;
   fclose(klee_warning_file);
@@ -485,6 +541,10 @@ void KleeHandler::processTestCase(const ExecutionState &state,
     exit(1);
   }
 
+  // another shard explores the same part of the tree and reports it
+  if (m_interpreter->isShardRedundant())
+    return;
+
   if (!NoOutput) {
     std::vector< std::pair<std::string, std::vector<unsigned char> > > out;
     bool success = m_interpreter->getSymbolicSolution(state, out);
@@ -515,7 +575,8 @@ void KleeHandler::processTestCase(const ExecutionState &state,
       }
 
       knTest_set_nodeId(&b, state.persistent.node.id);
-      knTest_set_dscenarioId(&b, m_dscenariosExplored);
+      // dscenario ids are interleaved among shards, so they stay unique after merging
+      knTest_set_dscenarioId(&b, m_dscenariosExplored * ShardWorkers + ShardIndex);
       std::string tmp = "no error";
       if (errorMessage && errorSuffix) {
         tmp = std::string(errorMessage);
@@ -523,7 +584,10 @@ void KleeHandler::processTestCase(const ExecutionState &state,
       }
       knTest_set_err(&b, const_cast<char*>(tmp.c_str()));
 
-      if (!kTest_toFile(&b, getOutputFilename(getTestFilename("ktest", id)).c_str())) {
+      if (m_archive) {
+        if (!knTestArchive_append(m_archive, &b, id))
+          klee_warning("unable to append test case to archive, losing it");
+      } else if (!kTest_toFile(&b, getOutputFilename(getTestFilename("ktest", id)).c_str())) {
         klee_warning("unable to write output test case, losing it");
       }
 
@@ -1226,6 +1290,170 @@ static llvm::Module *linkWithUclibc(llvm::Module *mainModule, StringRef libDir)
 }
 #endif
 
+// Moves the test cases of all shards into the output directory, numbering
+// them consecutively. Returns the number of test cases moved.
+static unsigned mergeShardOutputs() {
+  unsigned nextId = 0;
+  KnTestArchive *merged = 0;
+  if (WriteKnTestArchive) {
+    std::string const path = OutputDir + "/tests.knarc";
+    if (!(merged = knTestArchive_create(path.c_str(), KnTestArchiveChunk)))
+      fprintf(stderr, "KLEE: SHARDS: cannot create %s: %s\n", path.c_str(), strerror(errno));
+  }
+  for (unsigned shard = 0; shard < ShardWorkers; ++shard) {
+    std::stringstream dirName;
+    dirName << OutputDir << "/shard-" << shard;
+    DIR *dir = opendir(dirName.str().c_str());
+    if (!dir) {
+      fprintf(stderr, "KLEE: SHARDS: cannot open %s: %s\n", dirName.str().c_str(), strerror(errno));
+      continue;
+    }
+    // test<id>.<suffix>, grouped by id
+    std::map<unsigned, std::vector<std::string> > tests;
+    while (struct dirent *entry = readdir(dir)) {
+      unsigned id;
+      char dot;
+      if (sscanf(entry->d_name, "test%6u%c", &id, &dot) == 2 && dot == '.')
+        tests[id].push_back(entry->d_name);
+    }
+    closedir(dir);
+
+    // test cases in the shard's archive have no .ktest file of their own
+    std::string const archive = dirName.str() + "/tests.knarc";
+    bool const haveArchive = merged && knTestArchive_isArchive(archive.c_str());
+    KnTestArchive *a = haveArchive ? knTestArchive_open(archive.c_str()) : 0;
+    if (haveArchive && !a)
+      fprintf(stderr, "KLEE: SHARDS: cannot open %s: %s\n", archive.c_str(), strerror(errno));
+    if (a) {
+      unsigned id;
+      while (KTest *b = knTestArchive_next(a, &id)) {
+        tests[id];
+        kTest_free(b);
+      }
+      knTestArchive_close(a);
+    }
+
+    std::map<unsigned, unsigned> renumbered;
+    for (std::map<unsigned, std::vector<std::string> >::const_iterator
+           it = tests.begin(), ie = tests.end(); it != ie; ++it) {
+      renumbered[it->first] = ++nextId;
+      for (std::vector<std::string>::const_iterator
+             file = it->second.begin(), fe = it->second.end(); file != fe; ++file) {
+        std::stringstream to;
+        to << OutputDir << "/test" << std::setfill('0') << std::setw(6) << nextId
+           << file->substr(file->find('.'));
+        std::string const from = dirName.str() + "/" + *file;
+        if (rename(from.c_str(), to.str().c_str()) < 0)
+          fprintf(stderr, "KLEE: SHARDS: cannot move %s: %s\n", from.c_str(), strerror(errno));
+      }
+    }
+
+    a = haveArchive ? knTestArchive_open(archive.c_str()) : 0;
+    if (haveArchive && !a)
+      fprintf(stderr, "KLEE: SHARDS: cannot open %s: %s\n", archive.c_str(), strerror(errno));
+    if (a) {
+      unsigned id;
+      while (KTest *b = knTestArchive_next(a, &id)) {
+        if (!knTestArchive_append(merged, b, renumbered[id]))
+          fprintf(stderr, "KLEE: SHARDS: cannot append to %s/tests.knarc\n", OutputDir.c_str());
+        kTest_free(b);
+      }
+      knTestArchive_close(a);
+      unlink(archive.c_str());
+    }
+  }
+  if (merged && !knTestArchive_close(merged))
+    fprintf(stderr, "KLEE: SHARDS: cannot write %s/tests.knarc\n", OutputDir.c_str());
+  return nextId;
+}
+
+// Shards that share a range of shard indices took the same path so far, so
+// they have to log the same splits (see Executor::splitShard) until one of
+// them separates them. Reports the first disagreement of every pair of
+// shards; their test cases may then overlap or miss parts of the tree.
+static bool checkShardSplits() {
+  std::vector<std::vector<std::string> > splits(ShardWorkers);
+  for (unsigned shard = 0; shard < ShardWorkers; ++shard) {
+    std::stringstream path;
+    path << OutputDir << "/shard-" << shard << "/shard-splits.txt";
+    std::ifstream in(path.str().c_str());
+    std::string line;
+    while (std::getline(in, line))
+      splits[shard].push_back(line);
+  }
+
+  bool agreed = true;
+  for (unsigned a = 0; a < ShardWorkers; ++a) {
+    for (unsigned b = a + 1; b < ShardWorkers; ++b) {
+      unsigned const n = std::min(splits[a].size(), splits[b].size());
+      for (unsigned k = 0; k < n; ++k) {
+        unsigned beginA, endA, beginB, endB;
+        std::istringstream(splits[a][k]) >> beginA >> endA;
+        std::istringstream(splits[b][k]) >> beginB >> endB;
+        if (beginA != beginB || endA != endB)
+          break;
+        if (splits[a][k] != splits[b][k]) {
+          fprintf(stderr, "KLEE: SHARDS: workers %u and %u diverged at split %u\n", a, b, k + 1);
+          agreed = false;
+          break;
+        }
+      }
+    }
+  }
+  return agreed;
+}
+
+// Splits the run into ShardWorkers processes, each exploring a disjoint part
+// of the execution tree (see Interpreter::setShard) into its own
+// sub-directory of the output directory. Only returns in the workers; the
+// coordinator waits for all of them, merges their test cases and exits.
+static void runShardCoordinator() {
+  if (OutputDir == "")
+    klee_error("--shard-workers requires --output-dir");
+  if (mkdir(OutputDir.c_str(), 0775) < 0)
+    klee_error("cannot create \"%s\": %s", OutputDir.c_str(), strerror(errno));
+
+  std::vector<int> workers;
+  for (unsigned shard = 0; shard < ShardWorkers; ++shard) {
+    int pid = fork();
+    if (pid < 0)
+      klee_error("unable to fork shard worker %u", shard);
+    if (pid == 0) {
+      std::stringstream dirName;
+      dirName << OutputDir << "/shard-" << shard;
+      ShardIndex = shard;
+      OutputDir = dirName.str();
+      return;
+    }
+    workers.push_back(pid);
+  }
+  fprintf(stderr, "KLEE: SHARDS: started %u workers\n", ShardWorkers.getValue());
+
+  int result = 0;
+  for (unsigned shard = 0; shard < workers.size(); ++shard) {
+    int status;
+    while (waitpid(workers[shard], &status, 0) < 0) {
+      if (errno != EINTR) {
+        perror("shard waitpid");
+        exit(1);
+      }
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      fprintf(stderr, "KLEE: SHARDS: worker %u failed\n", shard);
+      result = 1;
+    }
+  }
+  if (!checkShardSplits()) {
+    fprintf(stderr, "KLEE: SHARDS: the workers did not make the same decisions before splitting, "
+                    "their test cases may overlap or miss paths\n");
+    result = 1;
+  }
+
+  unsigned const tests = mergeShardOutputs();
+  fprintf(stderr, "KLEE: SHARDS: merged %u test cases into %s\n", tests, OutputDir.c_str());
+  exit(result);
+}
+
 int main(int argc, char **argv, char **envp) {
   atexit(llvm_shutdown);  // Call llvm_shutdown() on exit.
 
@@ -1234,6 +1462,16 @@ int main(int argc, char **argv, char **envp) {
   parseArguments(argc, argv);
   sys::PrintStackTraceOnErrorSignal();
 
+  if (ShardWorkers > 1) {
+    if (ShardIndex >= ShardWorkers)
+      klee_error("--shard-index must be less than --shard-workers");
+    if (ReplayPathFile != "" || !ReplayOutFile.empty() || !ReplayOutDir.empty() ||
+        !SeedOutFile.empty() || !SeedOutDir.empty())
+      klee_error("--shard-workers cannot be combined with replaying or seeding");
+    if (!ShardIndex.getNumOccurrences())
+      runShardCoordinator();
+  }
+
   if (Watchdog) {
     if (MaxTime==0) {
       klee_error("--watchdog used without --max-time");
@@ -1472,6 +1710,11 @@ int main(int argc, char **argv, char **envp) {
     interpreter->setReplayPath(&replayPath);
   }
 
+  if (ShardWorkers > 1) {
+    interpreter->setShard(ShardIndex, ShardWorkers);
+    infoFile << "Shard: " << ShardIndex << " of " << ShardWorkers << "\n";
+  }
+
   char buf[256];
   time_t t[2];
   t[0] = time(NULL);
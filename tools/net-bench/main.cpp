@@ -0,0 +1,507 @@
+//===-- main.cpp ------------------------------------------------*- C++ -*-===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// net-bench drives the state mappers and the packet cache of the net library
+// with traces of branch/transmit/terminate events, without any symbolic
+// execution. A trace is either recorded from a kleenet run
+// (-sde-record-net-trace), or generated from a seed. The output is the time and
+// the number of heap allocations spent per operation.
+//
+//===----------------------------------------------------------------------===//
+
+#include "net/BasicState.h"
+#include "net/DataAtom.h"
+#include "net/NetStats.h"
+#include "net/Node.h"
+#include "net/PacketCache.h"
+#include "net/StateMapper.h"
+#include "net/TraceRecorder.h"
+#include "net/TransmitHandler.h"
+
+#include "llvm/Support/CommandLine.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace {
+  llvm::cl::opt<std::string>
+  InputFile(llvm::cl::desc("<trace>"), llvm::cl::Positional,
+      llvm::cl::init(""));
+
+  llvm::cl::opt<net::StateMappingType>
+  StateMapping("mapping",
+      llvm::cl::desc("State mapping algorithm to benchmark (sds by default)."),
+      llvm::cl::values(
+          clEnumValN(net::SM_COPY_ON_BRANCH, "cob", "Copy-On-Branch"),
+          clEnumValN(net::SM_COPY_ON_WRITE, "cow", "Copy-On-Write"),
+          clEnumValN(net::SM_COPY_ON_WRITE2, "cow2", "Copy-On-Write 2"),
+          clEnumValN(net::SM_SUPER_DSTATE, "sds", "Super-DState-Mapping"),
+          clEnumValN(net::SM_SUPER_DSTATE_WITH_BF_CLUS, "sds-bfc", "Super-DState-Mapping with brute-force clustering"),
+          clEnumValN(net::SM_SUPER_DSTATE_WITH_SMART_CLUS, "sds-sc", "Super-DState-Mapping with smart clustering"),
+          clEnumValEnd),
+      llvm::cl::init(net::SM_SUPER_DSTATE));
+
+  llvm::cl::opt<bool>
+  UsePhonyPackets("phony-packets",
+      llvm::cl::desc("Enable phony packets; the cache is then only committed every few transmissions."));
+
+  llvm::cl::opt<bool>
+  LazyExplosions("lazy-explosions",
+      llvm::cl::desc("Terminate clusters one dscenario at a time (default=on)."),
+      llvm::cl::init(true));
+
+  llvm::cl::opt<unsigned>
+  Nodes("nodes",
+      llvm::cl::desc("Number of nodes of a generated trace (default=4)."),
+      llvm::cl::init(4));
+
+  llvm::cl::opt<unsigned>
+  Steps("steps",
+      llvm::cl::desc("Number of events of a generated trace (default=10000)."),
+      llvm::cl::init(10000));
+
+  llvm::cl::opt<unsigned>
+  Seed("seed",
+      llvm::cl::desc("Seed of a generated trace (default=1)."),
+      llvm::cl::init(1));
+
+  llvm::cl::opt<unsigned>
+  MaxStates("max-states",
+      llvm::cl::desc("A generated trace terminates clusters while there are more states than this (default=1024)."),
+      llvm::cl::init(1024));
+
+  llvm::cl::opt<unsigned>
+  TerminateRate("terminate-rate",
+      llvm::cl::desc("Percentage of the events of a generated trace that terminate a cluster (default=0)."),
+      llvm::cl::init(0));
+
+  llvm::cl::opt<std::string>
+  RecordTrace("record-trace",
+      llvm::cl::desc("Write the trace that was run to this file, e.g. to keep a generated trace."));
+}
+
+//===----------------------------------------------------------------------===//
+// Allocation counting
+
+namespace {
+  uint64_t allocations = 0;
+  uint64_t allocatedBytes = 0;
+}
+
+void* operator new(size_t size) {
+  ++allocations;
+  allocatedBytes += size;
+  if (void* const p = malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+
+//===----------------------------------------------------------------------===//
+// The engine
+
+namespace {
+  class Bench;
+
+  class BenchState : public net::BasicState {
+    private:
+      Bench& bench;
+    public:
+      unsigned const id;
+      explicit BenchState(Bench& bench);
+      BenchState(BenchState const& from);
+      BenchState* forceFork() {
+        return new BenchState(*this);
+      }
+  };
+
+  struct BenchPacket {
+    net::Node dest;
+    explicit BenchPacket(net::Node dest) : dest(dest) {}
+    operator net::Node() const {
+      return dest;
+    }
+    bool operator<(BenchPacket const& other) const {
+      return dest < other.dest;
+    }
+  };
+
+  class BenchAtom : public net::DataAtomT<BenchAtom> {
+    private:
+      unsigned const key;
+      bool const distinct;
+    public:
+      BenchAtom(unsigned key, bool distinct) : key(key), distinct(distinct) {}
+      bool forceDistinction() const {
+        return distinct;
+      }
+      bool operator==(net::DataAtom const& other) const {
+        return key == static_cast<BenchAtom const&>(other).key;
+      }
+      bool operator<(net::DataAtom const& other) const {
+        return key < static_cast<BenchAtom const&>(other).key;
+      }
+  };
+
+  // the data itself is never looked at, so there is nothing to transmit
+  struct BenchTransmitHandler : net::TransmitHandler<BenchPacket> {
+    void handleTransmission(BenchPacket const&, net::BasicState*, net::BasicState*, net::ExData const&) const {
+    }
+  };
+
+  struct Event {
+    enum Kind { ROOT, BRANCH, NODE, CACHE, COMMIT, FIND, TERMINATE, KINDS };
+    Kind kind;
+    unsigned state;
+    net::Node node;
+    std::vector<std::pair<unsigned,bool> > atoms;
+    Event(Kind kind, unsigned state = 0, net::Node node = net::Node())
+      : kind(kind), state(state), node(node), atoms() {}
+  };
+
+  char const* const eventNames[Event::KINDS] = {
+    "root", "branch", "node", "cache", "commit", "find", "terminate"
+  };
+
+  struct Measurement {
+    uint64_t count;
+    uint64_t nanoseconds;
+    uint64_t allocations;
+    uint64_t bytes;
+    Measurement() : count(0), nanoseconds(0), allocations(0), bytes(0) {}
+  };
+
+  class Bench {
+    private:
+      typedef net::PacketCache<BenchPacket> PacketCache;
+      std::vector<BenchState*> states; // by id, NULL once terminated
+      std::vector<unsigned> live;
+      std::vector<unsigned> livePosition;
+      BenchTransmitHandler transmitHandler;
+      std::unique_ptr<net::StateMapper> stateMapper;
+      std::unique_ptr<PacketCache> packetCache;
+      Measurement measurements[Event::KINDS];
+      uint64_t skipped;
+
+      struct Collect : net::StateMapper::TerminateStateHandler {
+        std::set<net::BasicState*>& dead;
+        explicit Collect(std::set<net::BasicState*>& dead) : dead(dead) {}
+        void operator()(net::BasicState& state, std::vector<net::BasicState*> const& appendix) const {
+          dead.insert(&state);
+          dead.insert(appendix.begin(), appendix.end());
+        }
+      };
+
+      void retire(BenchState* state) {
+        unsigned const pos = livePosition[state->id];
+        live[pos] = live.back();
+        livePosition[live[pos]] = pos;
+        live.pop_back();
+        states[state->id] = NULL;
+        delete state;
+      }
+
+      void perform(Event const& ev) {
+        BenchState* const state = ev.kind == Event::COMMIT ? NULL : states[ev.state];
+        switch (ev.kind) {
+          case Event::ROOT:
+            break;
+          case Event::BRANCH:
+            new BenchState(*state);
+            break;
+          case Event::NODE:
+            net::StateMapper::setStateNode(state, ev.node);
+            break;
+          case Event::CACHE: {
+            net::ExData data;
+            data.reserve(ev.atoms.size());
+            for (std::vector<std::pair<unsigned,bool> >::const_iterator it = ev.atoms.begin(), end = ev.atoms.end(); it != end; ++it)
+              data.push_back(net::DataAtomHolder(net::util::SharedPtr<net::DataAtom>(new BenchAtom(it->first, it->second))));
+            packetCache->cacheMapping(state, BenchPacket(ev.node), data);
+            break;
+          }
+          case Event::COMMIT:
+            packetCache->commitMappings();
+            break;
+          case Event::FIND:
+            stateMapper->findTargets(state, ev.node);
+            stateMapper->invalidate();
+            break;
+          case Event::TERMINATE: {
+            std::set<net::BasicState*> dead;
+            stateMapper->terminateCluster(*state, Collect(dead));
+            for (std::set<net::BasicState*>::iterator it = dead.begin(), end = dead.end(); it != end; ++it)
+              retire(static_cast<BenchState*>(*it));
+            break;
+          }
+          case Event::KINDS:
+            break;
+        }
+      }
+
+    public:
+      Bench() : skipped(0) {
+        BenchState* const root = new BenchState(*this);
+        stateMapper.reset(net::StateMapper::create(StateMapping, UsePhonyPackets, root, LazyExplosions));
+        packetCache.reset(new PacketCache(*stateMapper, transmitHandler));
+      }
+
+      unsigned add(BenchState* state) {
+        unsigned const id = states.size();
+        states.push_back(state);
+        livePosition.push_back(live.size());
+        live.push_back(id);
+        return id;
+      }
+
+      /// Runs one event and measures it. Events on states that do not exist
+      /// (any more) are skipped: the ids of the states the mapper forks are
+      /// only stable as long as the mapper forks in the same order.
+      void run(Event const& ev) {
+        if (ev.kind != Event::COMMIT && (ev.state >= states.size() || !states[ev.state])) {
+          ++skipped;
+          return;
+        }
+        uint64_t const allocationsBefore = allocations;
+        uint64_t const bytesBefore = allocatedBytes;
+        std::chrono::steady_clock::time_point const start = std::chrono::steady_clock::now();
+        perform(ev);
+        std::chrono::steady_clock::duration const elapsed = std::chrono::steady_clock::now() - start;
+        Measurement& m = measurements[ev.kind];
+        m.count++;
+        m.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        m.allocations += allocations - allocationsBefore;
+        m.bytes += allocatedBytes - bytesBefore;
+      }
+
+      std::vector<unsigned> const& liveStates() const {
+        return live;
+      }
+
+      net::Node nodeOf(unsigned state) const {
+        return net::StateMapper::getStateNode(states[state]);
+      }
+
+      void report(std::ostream& out) const;
+  };
+
+  BenchState::BenchState(Bench& bench)
+    : BasicState(), bench(bench), id(bench.add(this)) {
+  }
+
+  BenchState::BenchState(BenchState const& from)
+    : BasicState(from), bench(from.bench), id(bench.add(this)) {
+  }
+
+  void Bench::report(std::ostream& out) const {
+    Measurement total;
+    out << std::left << std::setw(10) << "operation" << std::right
+        << std::setw(10) << "count"
+        << std::setw(12) << "total(ms)"
+        << std::setw(12) << "mean(us)"
+        << std::setw(12) << "allocs"
+        << std::setw(12) << "allocs/op"
+        << std::setw(12) << "bytes/op" << "\n";
+    for (unsigned k = Event::BRANCH; k != Event::KINDS; ++k) {
+      Measurement const& m = measurements[k];
+      total.count += m.count;
+      total.nanoseconds += m.nanoseconds;
+      total.allocations += m.allocations;
+      total.bytes += m.bytes;
+      unsigned long long const n = m.count ? m.count : 1;
+      out << std::left << std::setw(10) << eventNames[k] << std::right << std::fixed
+          << std::setw(10) << m.count
+          << std::setw(12) << std::setprecision(2) << m.nanoseconds / 1e6
+          << std::setw(12) << std::setprecision(3) << m.nanoseconds / 1e3 / n
+          << std::setw(12) << m.allocations
+          << std::setw(12) << std::setprecision(1) << static_cast<double>(m.allocations) / n
+          << std::setw(12) << std::setprecision(1) << static_cast<double>(m.bytes) / n << "\n";
+    }
+    out << std::left << std::setw(10) << "total" << std::right
+        << std::setw(10) << total.count
+        << std::setw(12) << std::setprecision(2) << total.nanoseconds / 1e6
+        << std::setw(12) << ""
+        << std::setw(12) << total.allocations << "\n\n";
+
+    out << "skipped events:        " << skipped << "\n"
+        << "states created:        " << states.size() << "\n"
+        << "states alive:          " << live.size() << "\n"
+        << "dscenarios:            " << stateMapper->countTotalDistributedScenarios() << "\n"
+        << "truncated dscenarios:  " << net::stats::truncatedDScenarios.getValue() << "\n"
+        << "transmissions:         " << net::stats::transmissions.getValue() << "\n"
+        << "redundant mappings:    " << net::stats::knownRedundantMappings.getValue() << "\n"
+        // these are inclusive and contained in the operations above
+        << "map time (ms):         " << net::stats::mapTime.getValue() / 1e3 << "\n"
+        << "explode time (ms):     " << net::stats::explodeTime.getValue() / 1e3 << "\n"
+        << "commit time (ms):      " << net::stats::commitMappingsTime.getValue() / 1e3 << "\n";
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// Traces
+
+namespace {
+  bool parseEvent(std::string const& line, Event& ev) {
+    std::istringstream in(line);
+    std::string kind;
+    if (!(in >> kind))
+      return false;
+    unsigned k = Event::ROOT;
+    while (k != Event::KINDS && kind != eventNames[k])
+      ++k;
+    ev = Event(static_cast<Event::Kind>(k));
+    switch (ev.kind) {
+      case Event::COMMIT:
+        return true;
+      case Event::ROOT:
+      case Event::BRANCH:
+      case Event::TERMINATE:
+        return static_cast<bool>(in >> ev.state);
+      case Event::NODE:
+      case Event::FIND:
+        return static_cast<bool>(in >> ev.state >> ev.node.id);
+      case Event::CACHE: {
+        if (!(in >> ev.state >> ev.node.id))
+          return false;
+        std::string atom;
+        while (in >> atom) {
+          char* end;
+          unsigned long const key = strtoul(atom.c_str(), &end, 10);
+          if (end == atom.c_str())
+            return false;
+          ev.atoms.push_back(std::make_pair(static_cast<unsigned>(key), *end == '*'));
+        }
+        return true;
+      }
+      case Event::KINDS:
+        break;
+    }
+    return false;
+  }
+
+  bool replay(Bench& bench, char const* path) {
+    std::ifstream in(path);
+    if (!in) {
+      std::cerr << "net-bench: error: cannot open " << path << "\n";
+      return false;
+    }
+    // parse everything up front, so that only the library is measured
+    std::vector<Event> events;
+    std::string line;
+    for (unsigned lineNo = 1; std::getline(in, line); ++lineNo) {
+      if (line.empty())
+        continue;
+      events.push_back(Event(Event::COMMIT));
+      if (!parseEvent(line, events.back())) {
+        std::cerr << "net-bench: error: " << path << ":" << lineNo << ": malformed event\n";
+        return false;
+      }
+    }
+    if (events.empty() || events.front().kind != Event::ROOT || events.front().state) {
+      std::cerr << "net-bench: error: " << path << " does not start with 'root 0'\n";
+      return false;
+    }
+    for (std::vector<Event>::const_iterator it = events.begin(), end = events.end(); it != end; ++it)
+      bench.run(*it);
+    return true;
+  }
+
+  /// Deterministic, so that generated traces do not depend on the platform.
+  class Random {
+    private:
+      uint64_t state;
+    public:
+      explicit Random(unsigned seed) : state(seed * 2654435761u + 1) {}
+      unsigned operator()(unsigned bound) {
+        state = state * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<unsigned>(state >> 33) % bound;
+      }
+  };
+
+  /// Boots one state per node like a kleenet program would, and then performs
+  /// random branches, transmissions, pulls and terminations.
+  void generate(Bench& bench) {
+    Random random(Seed);
+    for (unsigned n = 1; n < Nodes; ++n)
+      bench.run(Event(Event::BRANCH, 0));
+    std::vector<unsigned> const booted(bench.liveStates());
+    for (unsigned n = 0; n < booted.size(); ++n)
+      bench.run(Event(Event::NODE, booted[n], net::Node(n + 1)));
+
+    for (unsigned step = 0; step < Steps && !bench.liveStates().empty(); ++step) {
+      std::vector<unsigned> const& live = bench.liveStates();
+      unsigned const state = live[random(live.size())];
+      net::Node const node = bench.nodeOf(state);
+      net::Node dest(random(Nodes - 1) + 1);
+      if (dest >= node)
+        dest = dest.id + 1;
+      unsigned const action = random(100);
+      if (live.size() > MaxStates || action < TerminateRate) {
+        bench.run(Event(Event::TERMINATE, state));
+      } else if (action < 40) {
+        bench.run(Event(Event::BRANCH, state));
+      } else if (action < 85) {
+        Event ev(Event::CACHE, state, dest);
+        for (unsigned a = random(3) + 1; a; --a)
+          ev.atoms.push_back(std::make_pair(random(8), random(4) == 0));
+        bench.run(ev);
+        if (!UsePhonyPackets || random(4) == 0)
+          bench.run(Event(Event::COMMIT));
+      } else {
+        bench.run(Event(Event::FIND, state, dest));
+      }
+    }
+    bench.run(Event(Event::COMMIT));
+    // the end of the run
+    while (!bench.liveStates().empty())
+      bench.run(Event(Event::TERMINATE, bench.liveStates().front()));
+  }
+}
+
+int main(int argc, char** argv) {
+  llvm::cl::ParseCommandLineOptions(argc, argv, "net library micro-benchmark\n");
+
+  if (InputFile.empty() && Nodes < 2) {
+    std::cerr << "net-bench: error: a network needs at least two nodes\n";
+    return 1;
+  }
+  if (!RecordTrace.empty() && !net::TraceRecorder::start(RecordTrace.c_str())) {
+    std::cerr << "net-bench: error: cannot write " << RecordTrace << "\n";
+    return 1;
+  }
+
+  Bench bench;
+  if (InputFile.empty()) {
+    generate(bench);
+  } else if (!replay(bench, InputFile.c_str())) {
+    return 1;
+  }
+  net::TraceRecorder::stop();
+
+  bench.report(std::cout);
+  return 0;
+}
@@ -10,6 +10,7 @@
 #include <iostream>
 #include "gtest/gtest.h"
 
+#include "klee/Constraints.h"
 #include "klee/Expr.h"
 #include "klee/util/ArrayCache.h"
 
@@ -264,4 +265,130 @@ TEST(ExprTest, ReadExprFoldingSymbolicIndexUpdate) {
     EXPECT_EQ(Expr::Read, read.get()->getKind());
   }
 }
+
+TEST(ExprTest, DependentConstraints) {
+  ArrayCache ac;
+  const Array *a = ac.CreateArray("a", 4);
+  const Array *b = ac.CreateArray("b", 4);
+  const Array *c = ac.CreateArray("c", 4);
+  const Array *d = ac.CreateArray("d", 4);
+  const Array *e = ac.CreateArray("e", 4);
+
+  ref<Expr> c0 = UltExpr::create(Expr::createTempRead(a, 8),
+                                 Expr::createTempRead(b, 8));
+  ref<Expr> c1 = UltExpr::create(Expr::createTempRead(c, 8),
+                                 getConstant(5, 8));
+  ref<Expr> c2 = UltExpr::create(Expr::createTempRead(d, 8),
+                                 Expr::createTempRead(b, 8));
+  ref<Expr> c3 = UltExpr::create(Expr::createTempRead(c, 8),
+                                 Expr::createTempRead(d, 8));
+
+  ConstraintManager cm;
+  cm.addConstraint(c0);
+  cm.addConstraint(c1);
+  cm.addConstraint(c2);
+
+  std::vector<const Array*> arrays(1, a);
+  std::vector< ref<Expr> > result;
+  cm.getDependentConstraints(arrays, result);
+  ASSERT_EQ(2U, result.size());
+  EXPECT_EQ(c0, result[0]);
+  EXPECT_EQ(c2, result[1]);
+
+  result.clear();
+  arrays.assign(1, e);
+  cm.getDependentConstraints(arrays, result);
+  EXPECT_TRUE(result.empty());
+
+  // joining two classes hands out all their constraints in order
+  cm.addConstraint(c3);
+  result.clear();
+  arrays.assign(1, d);
+  cm.getDependentConstraints(arrays, result);
+  ASSERT_EQ(4U, result.size());
+  EXPECT_EQ(c0, result[0]);
+  EXPECT_EQ(c1, result[1]);
+  EXPECT_EQ(c2, result[2]);
+  EXPECT_EQ(c3, result[3]);
+
+  // the copy of a forked state keeps growing on its own
+  ConstraintManager copy(cm);
+  ref<Expr> c4 = UltExpr::create(Expr::createTempRead(e, 8),
+                                 getConstant(7, 8));
+  copy.addConstraint(c4);
+  result.clear();
+  arrays.assign(1, e);
+  copy.getDependentConstraints(arrays, result);
+  ASSERT_EQ(1U, result.size());
+  EXPECT_EQ(c4, result[0]);
+  result.clear();
+  cm.getDependentConstraints(arrays, result);
+  EXPECT_TRUE(result.empty());
+}
+
+/// Switches hash-consing on for one test and restores the previous setting
+/// afterwards, whatever the test does.
+class HashConsingTest : public ::testing::Test {
+  bool const saved;
+
+protected:
+  HashConsingTest() : saved(Expr::hashConsing) { Expr::hashConsing = true; }
+  ~HashConsingTest() { Expr::hashConsing = saved; }
+};
+
+TEST_F(HashConsingTest, SharesEqualNodes) {
+  ArrayCache ac;
+  const Array *a = ac.CreateArray("a", 4);
+  unsigned const before = Expr::count;
+  {
+    ref<Expr> e0 = AddExpr::create(Expr::createTempRead(a, 32),
+                                   getConstant(3, 32));
+    ref<Expr> e1 = AddExpr::create(Expr::createTempRead(a, 32),
+                                   getConstant(3, 32));
+    EXPECT_EQ(e0.get(), e1.get());
+    ref<Expr> e2 = AddExpr::create(Expr::createTempRead(a, 32),
+                                   getConstant(4, 32));
+    EXPECT_NE(e0.get(), e2.get());
+
+    // the table does not keep nodes alive
+    unsigned const live = Expr::count;
+    e0 = e2;
+    e1 = e2;
+    EXPECT_GT(live, Expr::count);
+    ref<Expr> e3 = AddExpr::create(Expr::createTempRead(a, 32),
+                                   getConstant(3, 32));
+    EXPECT_NE(e2.get(), e3.get());
+  }
+  EXPECT_EQ(before, Expr::count);
+}
+
+TEST_F(HashConsingTest, NodesOutliveSwitchingOff) {
+  ArrayCache ac;
+  const Array *a = ac.CreateArray("a", 4);
+  unsigned const before = Expr::count;
+  {
+    ref<Expr> e0 = AddExpr::create(Expr::createTempRead(a, 32),
+                                   getConstant(3, 32));
+    Expr *const consed = e0.get();
+
+    // a node built while consing is off is never found in the table
+    Expr::hashConsing = false;
+    ref<Expr> e1 = AddExpr::create(Expr::createTempRead(a, 32),
+                                   getConstant(3, 32));
+    EXPECT_NE(consed, e1.get());
+
+    // dying without consing must still remove the node from the table
+    e0 = e1;
+    Expr::hashConsing = true;
+    ref<Expr> e2 = AddExpr::create(Expr::createTempRead(a, 32),
+                                   getConstant(4, 32));
+    ref<Expr> e3 = AddExpr::create(Expr::createTempRead(a, 32),
+                                   getConstant(3, 32));
+    ref<Expr> e4 = AddExpr::create(Expr::createTempRead(a, 32),
+                                   getConstant(3, 32));
+    EXPECT_NE(e1.get(), e3.get());
+    EXPECT_EQ(e3.get(), e4.get());
+  }
+  EXPECT_EQ(before, Expr::count);
+}
 }
@@ -0,0 +1,191 @@
+//===-- CalendarQueueTest.cpp ---------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "net/CalendarQueue.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+using namespace net;
+
+namespace {
+
+typedef CalendarQueue::Event Event;
+
+class CalendarQueueTest : public ::testing::Test {
+protected:
+  CalendarQueue queue;
+  // the queue never looks at its states, so any distinct addresses will do
+  std::vector<char> tokens;
+
+  CalendarQueueTest() : tokens(4096) {}
+
+  BasicState *state(unsigned i) {
+    return reinterpret_cast<BasicState*>(&tokens.at(i));
+  }
+
+  Event *insert(Time time, NodeId node, unsigned i) {
+    Event *const ev = queue.insert(time, Node(node), state(i));
+    EXPECT_EQ(state(i), ev->state);
+    return ev;
+  }
+
+  /// Removes the earliest event and returns its state.
+  BasicState *pop() {
+    Event *const ev = queue.top();
+    EXPECT_TRUE(ev != 0);
+    if (!ev)
+      return 0;
+    BasicState *const s = ev->state;
+    queue.erase(ev);
+    return s;
+  }
+
+  /// Empties the queue, checking that events come out in order.
+  unsigned drain() {
+    unsigned n = 0;
+    Time lastTime = 0;
+    NodeId lastNode = 0;
+    while (Event *const ev = queue.top()) {
+      if (n) {
+        EXPECT_LE(lastTime, ev->time);
+        if (lastTime == ev->time)
+          EXPECT_LE(lastNode, ev->node.id);
+      }
+      lastTime = ev->time;
+      lastNode = ev->node.id;
+      queue.erase(ev);
+      ++n;
+    }
+    EXPECT_TRUE(queue.empty());
+    return n;
+  }
+};
+
+TEST_F(CalendarQueueTest, Empty) {
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(0u, queue.size());
+  EXPECT_TRUE(queue.top() == 0);
+  insert(5, 1, 0);
+  EXPECT_FALSE(queue.empty());
+  EXPECT_EQ(1u, queue.size());
+  EXPECT_EQ(state(0), pop());
+  EXPECT_TRUE(queue.empty());
+  EXPECT_TRUE(queue.top() == 0);
+}
+
+TEST_F(CalendarQueueTest, EqualTimesOrderByNodeThenInsertion) {
+  insert(7, 3, 0);
+  insert(7, 2, 1);
+  insert(7, 3, 2);
+  insert(7, 1, 3);
+  insert(7, 2, 4);
+  insert(6, 9, 5);
+  insert(8, 0, 6);
+
+  EXPECT_EQ(state(5), pop());
+  EXPECT_EQ(state(3), pop());
+  EXPECT_EQ(state(1), pop());
+  EXPECT_EQ(state(4), pop());
+  EXPECT_EQ(state(0), pop());
+  EXPECT_EQ(state(2), pop());
+  EXPECT_EQ(state(6), pop());
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(CalendarQueueTest, EarlierInsertionBecomesTop) {
+  insert(100, 0, 0);
+  EXPECT_EQ(state(0), queue.top()->state);
+  insert(3, 0, 1);
+  EXPECT_EQ(state(1), queue.top()->state);
+  // after popping, events before the search position must still be found
+  EXPECT_EQ(state(1), pop());
+  insert(50, 0, 2);
+  insert(1, 0, 3);
+  EXPECT_EQ(state(3), pop());
+  EXPECT_EQ(state(2), pop());
+  EXPECT_EQ(state(0), pop());
+}
+
+TEST_F(CalendarQueueTest, ResizesAsItGrowsAndShrinks) {
+  size_t const initial = queue.bucketCount();
+  unsigned const n = 3000;
+  std::srand(1);
+  for (unsigned i = 0; i < n; ++i)
+    insert(std::rand() % 100000, std::rand() % 8, i);
+  EXPECT_EQ(n, queue.size());
+  EXPECT_GE(2 * queue.bucketCount(), n);
+  size_t const grown = queue.bucketCount();
+  EXPECT_LT(initial, grown);
+
+  // pop most events, in order
+  Time last = 0;
+  for (unsigned i = 0; i < n - 10; ++i) {
+    Event *const ev = queue.top();
+    ASSERT_TRUE(ev != 0);
+    EXPECT_LE(last, ev->time);
+    last = ev->time;
+    queue.erase(ev);
+  }
+  EXPECT_EQ(10u, queue.size());
+  EXPECT_GT(grown, queue.bucketCount());
+  EXPECT_GE(20u, queue.bucketCount());
+
+  // and grow again with events before and after the rest
+  for (unsigned i = 0; i < 100; ++i)
+    insert(last + (i % 2 ? 1 : 1000) * i, 0, i);
+  EXPECT_EQ(110u, drain());
+}
+
+TEST_F(CalendarQueueTest, EraseFromTheMiddle) {
+  unsigned const n = 1000;
+  std::vector<Event*> events;
+  for (unsigned i = 0; i < n; ++i)
+    events.push_back(insert(i * 7 % n, i % 3, i));
+
+  // remove every event whose state has an odd index, wherever it is
+  for (unsigned i = 1; i < n; i += 2)
+    queue.erase(events[i]);
+  EXPECT_EQ(n / 2, queue.size());
+
+  std::vector<BasicState*> popped;
+  while (!queue.empty())
+    popped.push_back(pop());
+  ASSERT_EQ(n / 2, popped.size());
+  for (unsigned i = 0; i < popped.size(); ++i)
+    EXPECT_EQ(0, (reinterpret_cast<char*>(popped[i]) - &tokens[0]) % 2);
+
+  // the times are a permutation, so the survivors come out sorted by time
+  std::vector<Time> times;
+  for (unsigned i = 0; i < popped.size(); ++i) {
+    unsigned const idx = reinterpret_cast<char*>(popped[i]) - &tokens[0];
+    times.push_back(idx * 7 % n);
+  }
+  EXPECT_TRUE(std::adjacent_find(times.begin(), times.end(),
+                                 std::greater<Time>()) == times.end());
+}
+
+TEST_F(CalendarQueueTest, EraseTheTop) {
+  insert(10, 0, 0);
+  insert(20, 0, 1);
+  insert(30, 0, 2);
+  queue.erase(queue.top());
+  EXPECT_EQ(state(1), queue.top()->state);
+  Event *const ev = insert(15, 0, 3);
+  EXPECT_EQ(state(3), queue.top()->state);
+  queue.erase(ev);
+  EXPECT_EQ(state(1), pop());
+  EXPECT_EQ(state(2), pop());
+}
+
+}
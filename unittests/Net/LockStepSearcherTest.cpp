@@ -0,0 +1,195 @@
+//===-- LockStepSearcherTest.cpp ------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "net/BasicState.h"
+#include "net/Iterator.h"
+#include "net/LockStepSearcher.h"
+
+#include <set>
+#include <vector>
+
+using namespace net;
+
+namespace {
+
+/// States must live on the heap, the net library takes states on the stack
+/// for fakes.
+class TestState : public BasicState {
+public:
+  TestState *forceFork() { return new TestState(*this); }
+};
+
+typedef SingletonIterator<BasicState*> It;
+
+class LockStepSearcherTest : public ::testing::Test {
+protected:
+  LockStepSearcher searcher;
+  std::vector<BasicState*> states;
+
+  LockStepSearcherTest() : searcher(0) {}
+
+  ~LockStepSearcherTest() {
+    for (unsigned i = 0; i < states.size(); ++i)
+      if (states[i])
+        remove(states[i]);
+  }
+
+  BasicState *add(BasicState *state) {
+    states.push_back(state);
+    searcher.add(It(&state), It());
+    return state;
+  }
+
+  BasicState *add() {
+    return add(new TestState());
+  }
+
+  BasicState *fork(BasicState *parent) {
+    return add(static_cast<TestState*>(parent)->forceFork());
+  }
+
+  void remove(BasicState *state) {
+    searcher.remove(It(&state), It());
+    for (unsigned i = 0; i < states.size(); ++i)
+      if (states[i] == state)
+        states[i] = 0;
+    delete state;
+  }
+
+  /// Selects n states, which must all run at the same time.
+  std::multiset<BasicState*> step(unsigned n) {
+    std::multiset<BasicState*> selected;
+    Time time = 0;
+    for (unsigned i = 0; i < n; ++i) {
+      BasicState *const state = searcher.selectState();
+      if (i == 0)
+        time = searcher.getStateTime(state);
+      EXPECT_EQ(time, searcher.getStateTime(state));
+      selected.insert(state);
+    }
+    return selected;
+  }
+
+  static std::multiset<BasicState*> set(BasicState *a, BasicState *b = 0,
+                                        BasicState *c = 0) {
+    std::multiset<BasicState*> result;
+    result.insert(a);
+    if (b)
+      result.insert(b);
+    if (c)
+      result.insert(c);
+    return result;
+  }
+};
+
+TEST_F(LockStepSearcherTest, Empty) {
+  EXPECT_TRUE(searcher.empty());
+  BasicState *const a = add();
+  EXPECT_FALSE(searcher.empty());
+  BasicState *const b = add();
+  remove(a);
+  EXPECT_FALSE(searcher.empty());
+  remove(b);
+  EXPECT_TRUE(searcher.empty());
+}
+
+TEST_F(LockStepSearcherTest, EveryStateOncePerStep) {
+  BasicState *const a = add();
+  BasicState *const b = add();
+  BasicState *const c = add();
+
+  for (Time t = 0; t < 3; ++t) {
+    EXPECT_EQ(set(a, b, c), step(3));
+    EXPECT_EQ(t, searcher.getStateTime(a));
+    EXPECT_EQ(t, searcher.lowerBound());
+  }
+}
+
+TEST_F(LockStepSearcherTest, ForksJoinTheRightStep) {
+  BasicState *const a = add();
+  BasicState *const b = add();
+  step(2);
+
+  // a child of a state that already ran waits for the next step
+  BasicState *const a1 = fork(a);
+  EXPECT_EQ(set(a, b, a1), step(3));
+
+  // a child of a state that did not run yet runs in the same step
+  BasicState *const first = searcher.selectState();
+  BasicState *const pending = first == a ? b : a;
+  BasicState *const child = fork(pending);
+  std::multiset<BasicState*> rest = step(3);
+  rest.insert(first);
+  std::multiset<BasicState*> expected = set(a, b, a1);
+  expected.insert(child);
+  EXPECT_EQ(expected, rest);
+  EXPECT_EQ(searcher.getStateTime(first), searcher.getStateTime(child));
+}
+
+TEST_F(LockStepSearcherTest, RemoveDuringStep) {
+  BasicState *const a = add();
+  BasicState *const b = add();
+  BasicState *const c = add();
+  BasicState *const d = add();
+  step(4);
+
+  BasicState *const ran = searcher.selectState();
+  BasicState *pending = 0;
+  BasicState *const all[] = { a, b, c, d };
+  for (unsigned i = 0; i < 4 && !pending; ++i)
+    if (all[i] != ran)
+      pending = all[i];
+
+  // remove one state that already ran and one that still has to
+  remove(ran);
+  remove(pending);
+  std::multiset<BasicState*> left;
+  for (unsigned i = 0; i < 4; ++i)
+    if (all[i] != ran && all[i] != pending)
+      left.insert(all[i]);
+  EXPECT_EQ(left, step(2));
+  EXPECT_EQ(left, step(2));
+}
+
+TEST_F(LockStepSearcherTest, BarrierHoldsUntilEverybodyArrives) {
+  BasicState *const a = add();
+  BasicState *const b = add();
+  BasicState *const c = add();
+  step(3);
+
+  searcher.barrier(a);
+  EXPECT_FALSE(searcher.empty());
+  EXPECT_EQ(set(b, c), step(2));
+  searcher.barrier(b);
+  EXPECT_EQ(set(c), step(1));
+  EXPECT_EQ(set(c), step(1));
+
+  // a child of a blocked state is blocked as well
+  BasicState *const a1 = fork(a);
+  EXPECT_EQ(set(c), step(1));
+
+  // the last one to arrive releases everybody
+  searcher.barrier(c);
+  std::multiset<BasicState*> expected = set(a, b, c);
+  expected.insert(a1);
+  EXPECT_EQ(expected, step(4));
+  EXPECT_EQ(expected, step(4));
+
+  // leaving while blocked does not hold up the others
+  searcher.barrier(a1);
+  remove(a1);
+  searcher.barrier(a);
+  searcher.barrier(b);
+  searcher.barrier(c);
+  EXPECT_EQ(set(a, b, c), step(3));
+}
+
+}
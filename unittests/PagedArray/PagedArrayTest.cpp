@@ -0,0 +1,142 @@
+//===-- PagedArrayTest.cpp ------------------------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/util/PagedArray.h"
+
+#include <vector>
+
+using namespace klee;
+
+namespace {
+
+typedef PagedArray<int> Array;
+
+unsigned const PageSize = Array::PageSize;
+// three full pages and a short last one
+unsigned const Size = 3 * PageSize + 5;
+
+// Copies share a page if they hand out the same storage for its elements.
+bool sharesPage(const Array &a, const Array &b, unsigned page) {
+  return &a[page * PageSize] == &b[page * PageSize];
+}
+
+bool isNonZero(int v) {
+  return v != 0;
+}
+
+TEST(PagedArrayTest, CopySharesPages) {
+  Array a(Size);
+  EXPECT_EQ(Size, a.size());
+  for (unsigned i = 0; i != Size; ++i)
+    EXPECT_EQ(0, a[i]);
+
+  Array b(a);
+  EXPECT_EQ(Size, b.size());
+  for (unsigned p = 0; p != 4; ++p)
+    EXPECT_TRUE(sharesPage(a, b, p));
+}
+
+TEST(PagedArrayTest, WriteUnsharesOnlyItsPage) {
+  Array a(Size);
+  Array b(a);
+  b.getWriteable(PageSize + 1) = 7;
+
+  EXPECT_TRUE(sharesPage(a, b, 0));
+  EXPECT_FALSE(sharesPage(a, b, 1));
+  EXPECT_TRUE(sharesPage(a, b, 2));
+  EXPECT_TRUE(sharesPage(a, b, 3));
+  EXPECT_EQ(7, b[PageSize + 1]);
+  EXPECT_EQ(0, a[PageSize + 1]);
+}
+
+TEST(PagedArrayTest, FillAcrossPages) {
+  Array a(Size);
+  unsigned const begin = PageSize - 2, end = 3 * PageSize + 3;
+  a.fill(begin, end, 9);
+  for (unsigned i = 0; i != Size; ++i)
+    EXPECT_EQ(i >= begin && i < end ? 9 : 0, a[i]) << "at " << i;
+}
+
+TEST(PagedArrayTest, WriteAcrossPages) {
+  Array a(Size);
+  std::vector<int> values;
+  for (unsigned i = 0; i != PageSize + 4; ++i)
+    values.push_back(i + 1);
+  unsigned const offset = PageSize - 2;
+  a.write(offset, &values[0], values.size());
+  for (unsigned i = 0; i != Size; ++i) {
+    if (i >= offset && i < offset + values.size())
+      EXPECT_EQ(int(i - offset + 1), a[i]) << "at " << i;
+    else
+      EXPECT_EQ(0, a[i]) << "at " << i;
+  }
+
+  std::vector<int> all(Size);
+  a.read(&all[0]);
+  EXPECT_TRUE(a.equals(&all[0]));
+  all[Size - 1] = 1;
+  EXPECT_FALSE(a.equals(&all[0]));
+}
+
+TEST(PagedArrayTest, FillKeepsCleanPagesShared) {
+  Array a(Size);
+  a.getWriteable(2 * PageSize) = 5;
+  Array b(a);
+
+  // only page 2 holds an element that has to be cleared
+  b.fill(0, Size, 0, isNonZero);
+  EXPECT_TRUE(sharesPage(a, b, 0));
+  EXPECT_TRUE(sharesPage(a, b, 1));
+  EXPECT_FALSE(sharesPage(a, b, 2));
+  EXPECT_TRUE(sharesPage(a, b, 3));
+  EXPECT_EQ(0, b[2 * PageSize]);
+  EXPECT_EQ(5, a[2 * PageSize]);
+
+  // nothing left to clear
+  Array c(b);
+  c.fill(0, Size, 0, isNonZero);
+  for (unsigned p = 0; p != 4; ++p)
+    EXPECT_TRUE(sharesPage(b, c, p));
+}
+
+TEST(PagedArrayTest, IndependentAfterCopy) {
+  Array a(Size);
+  a.fill(0, Size, 1);
+  Array b(a);
+
+  a.fill(PageSize - 1, PageSize + 1, 2);
+  b.getWriteable(Size - 1) = 3;
+  std::vector<int> values(Size, 4);
+  Array c(b);
+  c.assign(&values[0]);
+
+  for (unsigned i = 0; i != Size; ++i) {
+    EXPECT_EQ(i == PageSize - 1 || i == PageSize ? 2 : 1, a[i]) << "at " << i;
+    EXPECT_EQ(i == Size - 1 ? 3 : 1, b[i]) << "at " << i;
+    EXPECT_EQ(4, c[i]) << "at " << i;
+  }
+}
+
+TEST(PagedArrayTest, AssignKeepsEqualPagesShared) {
+  Array a(Size);
+  Array b(a);
+  std::vector<int> values(Size, 0);
+  values[3 * PageSize + 4] = 1;
+  b.assign(&values[0]);
+
+  for (unsigned p = 0; p != 3; ++p)
+    EXPECT_TRUE(sharesPage(a, b, p));
+  EXPECT_FALSE(sharesPage(a, b, 3));
+  EXPECT_EQ(1, b[3 * PageSize + 4]);
+  EXPECT_EQ(0, a[3 * PageSize + 4]);
+}
+
+}
@@ -13,6 +13,9 @@
 #include "gtest/gtest.h"
 #include <iostream>
 #include "klee/util/Ref.h"
+#ifdef KLEE_ENABLE_THREAD_SAFE_EXPRS
+#include <pthread.h>
+#endif
 using klee::ref;
 
 int finished = 0;
@@ -38,3 +41,34 @@ TEST(RefTest, SelfAssign)
   EXPECT_EQ(r_e->refCount, 1);
   finished = 1;
 }
+
+#ifdef KLEE_ENABLE_THREAD_SAFE_EXPRS
+struct Shared
+{
+  unsigned refCount;
+  Shared() : refCount(0) {}
+};
+
+static void *copyShared(void *arg) {
+  ref<Shared> const &r = *static_cast<ref<Shared> *>(arg);
+  for (unsigned i = 0; i < 100000; ++i) {
+    ref<Shared> copy(r);
+    ref<Shared> other;
+    other = copy;
+  }
+  return 0;
+}
+
+TEST(RefTest, ConcurrentCopies)
+{
+  klee::shareExprsBetweenThreads();
+  Shared *s = new Shared();
+  ref<Shared> r(s);
+  pthread_t threads[4];
+  for (unsigned i = 0; i < 4; ++i)
+    ASSERT_EQ(pthread_create(&threads[i], 0, copyShared, &r), 0);
+  for (unsigned i = 0; i < 4; ++i)
+    pthread_join(threads[i], 0);
+  EXPECT_EQ(s->refCount, 1u);
+}
+#endif
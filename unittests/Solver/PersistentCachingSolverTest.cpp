@@ -0,0 +1,241 @@
+//===-- PersistentCachingSolverTest.cpp -----------------------------------===//
+//
+//                     The KLEE Symbolic Virtual Machine
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+
+#include "klee/Constraints.h"
+#include "klee/Expr.h"
+#include "klee/Solver.h"
+#include "klee/SolverImpl.h"
+#include "klee/util/ArrayCache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace klee;
+
+namespace {
+
+ArrayCache ac;
+
+/// Answers every query the same way and counts how often it was asked.
+class CountingSolver : public SolverImpl {
+  unsigned &calls;
+
+public:
+  explicit CountingSolver(unsigned &calls) : calls(calls) {}
+
+  bool computeTruth(const Query&, bool &isValid) {
+    ++calls;
+    isValid = true;
+    return true;
+  }
+  bool computeValidity(const Query&, Solver::Validity &result) {
+    ++calls;
+    result = Solver::True;
+    return true;
+  }
+  bool computeValue(const Query&, ref<Expr> &result) {
+    ++calls;
+    result = ConstantExpr::create(5, Expr::Int8);
+    return true;
+  }
+  bool computeInitialValues(const Query&,
+                            const std::vector<const Array*> &objects,
+                            std::vector< std::vector<unsigned char> > &values,
+                            bool &hasSolution) {
+    ++calls;
+    values.clear();
+    for (unsigned i = 0; i < objects.size(); ++i)
+      values.push_back(std::vector<unsigned char>(objects[i]->size, 5));
+    hasSolution = true;
+    return true;
+  }
+  SolverRunStatus getOperationStatusCode() {
+    return SOLVER_RUN_STATUS_SUCCESS_SOLVABLE;
+  }
+};
+
+class PersistentCachingSolverTest : public ::testing::Test {
+protected:
+  std::string path;
+  const Array *array;
+  ConstraintManager constraints;
+  ref<Expr> expr;
+
+  void SetUp() {
+    char name[] = "/tmp/kleePQCXXXXXX";
+    int fd = mkstemp(name);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    path = name;
+
+    array = ac.CreateArray("pqc", 1);
+    expr = EqExpr::create(Expr::createTempRead(array, Expr::Int8),
+                          ConstantExpr::create(5, Expr::Int8));
+  }
+
+  void TearDown() {
+    unlink(path.c_str());
+  }
+
+  Solver *open(unsigned &calls) {
+    return createPersistentCachingSolver(new Solver(new CountingSolver(calls)),
+                                         path);
+  }
+
+  std::string readFile() {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in),
+                       std::istreambuf_iterator<char>());
+  }
+
+  void writeFile(const std::string &contents) {
+    std::ofstream out(path.c_str(), std::ios::binary | std::ios::trunc);
+    out << contents;
+  }
+};
+
+TEST_F(PersistentCachingSolverTest, RoundTrip) {
+  unsigned calls = 0;
+  Solver *solver = open(calls);
+  Query query(constraints, expr);
+  std::vector<const Array*> objects(1, array);
+
+  bool isValid = false;
+  ASSERT_TRUE(solver->mustBeTrue(query, isValid));
+  EXPECT_TRUE(isValid);
+  std::vector< std::vector<unsigned char> > values;
+  ASSERT_TRUE(solver->getInitialValues(query, objects, values));
+  EXPECT_EQ(2u, calls);
+
+  isValid = false;
+  values.clear();
+  ASSERT_TRUE(solver->mustBeTrue(query, isValid));
+  ASSERT_TRUE(solver->getInitialValues(query, objects, values));
+  EXPECT_EQ(2u, calls);
+  EXPECT_TRUE(isValid);
+  ASSERT_EQ(1u, values.size());
+  EXPECT_EQ(std::vector<unsigned char>(1, 5), values[0]);
+
+  delete solver;
+}
+
+TEST_F(PersistentCachingSolverTest, Reopen) {
+  Query query(constraints, expr);
+  std::vector<const Array*> objects(1, array);
+
+  unsigned calls = 0;
+  Solver *solver = open(calls);
+  bool isValid = false;
+  std::vector< std::vector<unsigned char> > values;
+  ASSERT_TRUE(solver->mustBeTrue(query, isValid));
+  ASSERT_TRUE(solver->getInitialValues(query, objects, values));
+  delete solver;
+  EXPECT_EQ(2u, calls);
+
+  // A new run answers both queries from the file alone.
+  unsigned reopenedCalls = 0;
+  solver = open(reopenedCalls);
+  isValid = false;
+  values.clear();
+  ASSERT_TRUE(solver->mustBeTrue(query, isValid));
+  ASSERT_TRUE(solver->getInitialValues(query, objects, values));
+  EXPECT_EQ(0u, reopenedCalls);
+  EXPECT_TRUE(isValid);
+  ASSERT_EQ(1u, values.size());
+  EXPECT_EQ(std::vector<unsigned char>(1, 5), values[0]);
+
+  // A query that was never asked still goes to the underlying solver.
+  ref<Expr> other = EqExpr::create(Expr::createTempRead(array, Expr::Int8),
+                                   ConstantExpr::create(6, Expr::Int8));
+  ASSERT_TRUE(solver->mustBeTrue(Query(constraints, other), isValid));
+  EXPECT_EQ(1u, reopenedCalls);
+  delete solver;
+}
+
+TEST_F(PersistentCachingSolverTest, DamagedRecord) {
+  Query query(constraints, expr);
+
+  unsigned calls = 0;
+  Solver *solver = open(calls);
+  bool isValid = false;
+  ASSERT_TRUE(solver->mustBeTrue(query, isValid));
+  delete solver;
+  EXPECT_EQ(1u, calls);
+
+  // Change one character of the recorded query text, leaving its length
+  // and everything else in the file alone. The record fails its checksum
+  // and must no longer be taken for the query.
+  std::string contents = readFile();
+  std::string::size_type pos = contents.find("pqc");
+  ASSERT_NE(std::string::npos, pos);
+  contents[pos] = 'x';
+  writeFile(contents);
+
+  unsigned reopenedCalls = 0;
+  solver = open(reopenedCalls);
+  ASSERT_TRUE(solver->mustBeTrue(query, isValid));
+  EXPECT_EQ(1u, reopenedCalls);
+  delete solver;
+}
+
+TEST_F(PersistentCachingSolverTest, ConcurrentWriters) {
+  // Records larger than any stdio buffer, appended by several processes at
+  // once, must all come back intact.
+  const Array *big = ac.CreateArray("pqcbig", 3 * BUFSIZ);
+  std::vector<const Array*> objects(1, big);
+  unsigned const writers = 4, queries = 16;
+
+  std::vector<pid_t> children;
+  for (unsigned w = 0; w < writers; ++w) {
+    pid_t const pid = fork();
+    ASSERT_NE(-1, pid);
+    if (pid == 0) {
+      unsigned calls = 0;
+      Solver *solver = open(calls);
+      for (unsigned q = 0; q < queries; ++q) {
+        ref<Expr> e = EqExpr::create(Expr::createTempRead(big, Expr::Int8),
+                                     ConstantExpr::create(w * queries + q,
+                                                          Expr::Int8));
+        std::vector< std::vector<unsigned char> > values;
+        solver->getInitialValues(Query(constraints, e), objects, values);
+      }
+      delete solver;
+      _exit(calls == queries ? 0 : 1);
+    }
+    children.push_back(pid);
+  }
+  for (unsigned i = 0; i < children.size(); ++i) {
+    int status;
+    ASSERT_EQ(children[i], waitpid(children[i], &status, 0));
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+
+  unsigned calls = 0;
+  Solver *solver = open(calls);
+  for (unsigned i = 0; i < writers * queries; ++i) {
+    ref<Expr> e = EqExpr::create(Expr::createTempRead(big, Expr::Int8),
+                                 ConstantExpr::create(i, Expr::Int8));
+    std::vector< std::vector<unsigned char> > values;
+    ASSERT_TRUE(solver->getInitialValues(Query(constraints, e), objects,
+                                         values));
+    ASSERT_EQ(1u, values.size());
+    EXPECT_EQ(std::vector<unsigned char>(3 * BUFSIZ, 5), values[0]);
+  }
+  EXPECT_EQ(0u, calls);
+  delete solver;
+}
+
+}